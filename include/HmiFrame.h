@@ -0,0 +1,74 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     HmiFrame.h
+  Purpose:  Builds the frames with navigation values for the HMI, like
+            "COG=213.2#AWA=-37.0#SOG=6.4#"
+
+  NOTES:    The HMI parses the keys of a frame in any order and keeps the
+            value of a key that isn't in the frame. So the encoder remembers
+            what it sent per key and only puts the keys that changed in a
+            frame; a frame is empty if nothing changed. Only the keys the
+            NavState marked dirty are compared, so the caller cleans the
+            state after every encode.
+            Every refresh interval a frame with all keys is sent, so the HMI
+            catches up after a reset or a lost frame.
+            The statistics compare the bytes sent with the bytes the same
+            frames would have taken with all keys in them.
+            The frames are written to the text component nmea on page 1 of
+            the HMI, see the .HMI file in Nextion/. Its txt_maxl must be at
+            least HMI_TXT_MAXL, a frame with all keys at their longest
+            value, or the last keys of a full frame are lost. The HMI
+            parses the keys COG, AWA, SOG, AWS, BAT, DPT, TWS, TWA, TWD,
+            VMG, MWD and MXW, each value with 1 decimal.
+*/
+#ifndef __HMIFRAME_H__
+#define __HMIFRAME_H__
+
+#include <Arduino.h>
+#include "NavState.h"
+
+#define HMI_FRAME_SIZE 255     // longest frame incl. '\0'
+#define HMI_TXT_MAXL (NAV_KEYS * (4 + NAV_TEXT_SIZE)) // NAV_KEYS times "<tag>=<value>#"
+#define HMI_FRAME_REFRESH 5000 // ms between frames with all keys
+
+struct HmiFrameStats
+{
+  uint32_t frames;     // frames built
+  uint32_t fullFrames; // frames with all keys, refreshes included
+  uint32_t keys;       // keys sent
+  uint32_t bytes;      // bytes sent
+  uint32_t fullBytes;  // bytes if every frame had all keys
+};
+
+class HmiFrame
+{
+public:
+  HmiFrame();
+
+  /*** Builds the frame of the keys that changed since the last frame in dst
+   * of HMI_FRAME_SIZE chars, or of all keys if a refresh is due at now (ms)
+   * @return the length of the frame, 0 if there is nothing to send
+   */
+  uint8_t encode(const NavState &state, unsigned long now, char *dst);
+
+  /*** Makes the next frame a frame with all keys
+   */
+  void refresh() { _refreshDue = true; }
+
+  const HmiFrameStats &stats() const { return _stats; }
+
+private:
+  struct Sent
+  {
+    bool valid;
+    int32_t tenths;
+    uint8_t len; // of "<tag><value>#"
+  };
+
+  Sent _sent[NAV_KEYS];
+  bool _refreshDue;
+  unsigned long _lastRefresh;
+  HmiFrameStats _stats;
+};
+
+#endif /* #ifndef __HMIFRAME_H__ */
@@ -0,0 +1,104 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     NavState.h
+  Purpose:  Typed store of the navigation values shown on the HMI
+
+  NOTES:    Values are parsed once when the sentence is processed and kept
+            as integers in tenths, i.e. an AWA of 37.5 degrees port is -375.
+            Every value has a validity flag; a value is invalid until it is
+            received and the frame shows a placeholder for it.
+            They are only formatted as text when a frame is sent to the HMI,
+            so no strings are copied, checked or converted per sentence.
+            A value that changes is marked dirty. Derived values, like the
+            true wind, are nodes with a mask of the values they depend on;
+            derive() only recalculates the nodes of which an input is dirty,
+            in the order of the table, so a node may depend on the outputs
+            of the nodes before it. A depth or battery value doesn't make
+            the true wind recalculate, and the frame only looks at the dirty
+            values.
+*/
+#ifndef __NAVSTATE_H__
+#define __NAVSTATE_H__
+
+#include <Arduino.h>
+
+#define NAV_TEXT_SIZE 13 // longest formatted value "-214748364.8" + '\0'
+
+//*** keys of the navigation values
+enum navKey
+{
+  NAV_AWA,
+  NAV_COG,
+  NAV_SOG,
+  NAV_AWS,
+  NAV_BAT,
+  NAV_DPT,
+  NAV_TWS, // derived from the values above, not received
+  NAV_TWA, // derived
+  NAV_TWD, // derived
+  NAV_VMG, // derived
+  NAV_MWD, // mean TWD over the wind history
+  NAV_MXW, // highest TWS of the samples in the wind history, not a gust
+  NAV_KEYS
+};
+
+#define NAV_BIT(key) (1 << (key))
+
+class NavState;
+
+/*** Recalculates the outputs of a node from the state
+*/
+typedef void (*NavDerive)(NavState &state);
+
+/*** A derived value in the dependency graph
+*/
+struct NavNode
+{
+  uint16_t inputs; // NAV_BITs of the values it is calculated from
+  NavDerive derive;
+};
+
+class NavState
+{
+public:
+  NavState();
+
+  /*** Sets or invalidates a value, it is marked dirty if it changed
+   */
+  void set(uint8_t key, int32_t tenths);
+  void invalidate(uint8_t key);
+
+  bool valid(uint8_t key) const { return (_valid & (1 << key)) != 0; }
+  int32_t tenths(uint8_t key) const { return _tenths[key]; }
+
+  /*** Sets the nodes of the derived values, in the order they are derived
+   */
+  void setNodes(const NavNode *nodes, uint8_t count);
+
+  /*** Recalculates the nodes of which an input is dirty
+   */
+  void derive();
+
+  /*** Returns the NAV_BITs of the values changed since clean()
+   */
+  uint16_t dirty() const { return _dirty; }
+  void clean() { _dirty = 0; }
+
+  uint32_t derivations() const { return _derivations; }
+
+private:
+  int32_t _tenths[NAV_KEYS];
+  uint16_t _valid; // bit per key
+  uint16_t _dirty; // bit per key
+  const NavNode *_nodes;
+  uint8_t _nrOfNodes;
+  uint32_t _derivations; // nodes recalculated
+};
+
+/*** Formats tenths as a value with 1 decimal like "-37.5" in dst, which
+ * must hold NAV_TEXT_SIZE characters.
+ * @return the nr of characters written, without the '\0'
+ */
+uint8_t navFormatTenths(int32_t tenths, char *dst);
+
+#endif /* #ifndef __NAVSTATE_H__ */
@@ -0,0 +1,67 @@
+/**
+ * @file NexCommand.h
+ *
+ * The definition of class NexCommand. 
+ *
+ * @copyright 
+ * Copyright (C) 2014-2015 ITEAD Intelligent Systems Co., Ltd. \n
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * Replaces the String the components built their commands with, which
+ * allocated heap memory for every get and set.
+ */
+#ifndef __NEXCOMMAND_H__
+#define __NEXCOMMAND_H__
+
+#include <Arduino.h>
+#include "NexConfig.h"
+
+/**
+ * @addtogroup CoreAPI 
+ * @{ 
+ */
+
+/**
+ * Builds a command in a buffer of NEX_CMD_SIZE chars on the stack. 
+ *
+ * Appends like a String, but never allocates memory. A command which
+ * doesn't fit is truncated and counted, see overflows().
+ */
+class NexCommand
+{
+public: /* methods */
+
+    NexCommand(void);
+
+    /**
+     * Constructor. 
+     *
+     * @param str - the start of the command. 
+     */
+    NexCommand(const char *str);
+
+    NexCommand &operator=(const char *str);
+    NexCommand &operator+=(const char *str);
+    NexCommand &operator+=(char c);
+
+    const char *c_str(void) const { return __buf; }
+    uint16_t length(void) const { return __len; }
+
+    /**
+     * @return the nr of commands truncated since the start.
+     */
+    static uint32_t overflows(void) { return __overflows; }
+
+private: /* data */
+    char __buf[NEX_CMD_SIZE];
+    uint16_t __len;
+    static uint32_t __overflows;
+};
+/**
+ * @}
+ */
+
+#endif /* #ifndef __NEXCOMMAND_H__ */
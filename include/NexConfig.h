@@ -15,6 +15,8 @@
 #ifndef __NEXCONFIG_H__
 #define __NEXCONFIG_H__
 
+#include "SerialTransport.h"
+
 /**
  * @addtogroup Configuration 
  * @{ 
@@ -26,15 +28,89 @@
  */
 #define DEBUG_SERIAL_ENABLE
 
+/** 
+ * Define DEBUG_TOUCH_ENABLE to print the component of every touch event. 
+ */
+//#define DEBUG_TOUCH_ENABLE
+
+/**
+ * Transports used for debug messages and for the Nextion touch panel.
+ * On the ESP32 these default to Serial and Serial2, a native build has
+ * to set them before calling nexInit().
+ */
+extern SerialTransport *dbTransport;
+extern SerialTransport *nexTransport;
+
+/**
+ * Storage of the baudrate of the display link, see nexNegotiateBaud(). 
+ * On the ESP32 it is kept with Preferences, a native build has to provide
+ * them. nexLoadBaud() returns 0 when nothing is stored. 
+ */
+uint32_t nexLoadBaud(void);
+void nexSaveBaud(uint32_t baud);
+
+/**
+ * GPIO pins of the UART connected to the Nextion touch panel.
+ */
+#define NEX_RX_PIN 16
+#define NEX_TX_PIN 17
+
+/**
+ * Baudrate the HMI is set up for, used when no other rate is stored. 
+ */
+#define NEX_BAUD 115200
+
+/**
+ * Max nr of asynchronous commands waiting for their reply, see
+ * nexAsyncBegin(). Must be a power of 2.
+ */
+#define NEX_ASYNC_QUEUE 16
+
+/**
+ * Time in ms an asynchronous command may wait for its reply.
+ */
+#define NEX_ASYNC_TIMEOUT 100
+
+/**
+ * Size of the buffer commands are collected in before they are written to
+ * the display, see nexBatchBegin().
+ */
+#define NEX_TX_BUFFER 256
+
+/**
+ * Longest command a component can build, see NexCommand. Enough for a
+ * 255 char text assigned to a component with the longest name.
+ */
+#define NEX_CMD_SIZE 300
+
+/**
+ * Max nr of components a redraw transaction collects, see
+ * NexObject::beginRedraw(). 
+ */
+#define NEX_REDRAW_MAX 16
+
+/**
+ * Longest string the display can send by itself, i.e. with prints, that
+ * is passed to the string handler, see nexSetHandlers(). 
+ */
+#define NEX_RX_STRING 64
+
+/**
+ * Slots of the index of the touch components, see NexTouch::buildIndex().
+ * Must be a power of 2, at most 256. A listen list with more than 3/4 of
+ * it is walked instead. 
+ */
+#define NEX_TOUCH_INDEX 64
+
 /**
  * Define dbSerial for the output of debug messages. 
  */
-#define dbSerial Serial
+#define dbSerial (*dbTransport)
 
 /**
  * Define nexSerial for communicate with Nextion touch panel. 
  */
-#define nexSerial Serial2
+#define nexSerial (*nexTransport)
 
 
 #ifdef DEBUG_SERIAL_ENABLE
@@ -13,13 +13,17 @@
  * the License, or (at your option) any later version.
  * 
  * 02-10-2020 Added function printError for debugging purposes
+ * Added asynchronous commands, see nexAsyncBegin()
+ * Added batches of commands written at once, see nexBatchBegin()
+ * Added handlers of all events and replies, see nexSetHandlers()
+ * Added negotiation of a faster link, see nexNegotiateBaud()
  */
 #ifndef __NEXHARDWARE_H__
 #define __NEXHARDWARE_H__
 #include <Arduino.h>
 #include "NexConfig.h"
 #include "NexTouch.h"
-#include <HardwareSerial.h>
+#include "NexCommand.h"
 /**
  * @addtogroup CoreAPI 
  * @{ 
@@ -28,14 +32,59 @@
 /**
  * Init Nextion.  
  * 
+ * The link is opened at the stored baudrate, or NEX_BAUD, and the other
+ * rates are tried when the display doesn't reply, see nexFindBaud(). 
+ *
+ * @param baud - rate to negotiate with nexNegotiateBaud(), 0 to keep it. 
  * @return true if success, false for failure. 
  */
-bool nexInit(void);
+bool nexInit(uint32_t baud = 0);
+
+/**
+ * Finds the baudrate the display listens at. 
+ *
+ * Tries the rate the link is open at, then NEX_BAUD and then all rates the
+ * display supports, from fast to slow, until the display replies to
+ * bkcmd=1. A rate other than the stored one is stored. 
+ *
+ * @return the rate, 0 if the display doesn't reply at any rate. 
+ */
+uint32_t nexFindBaud(void);
+
+/**
+ * Tries one rate of nexFindBaud(), so the search can be spread over the
+ * passes of loop(). Every call probes at most one rate. 
+ *
+ * @param step - 0 to start the search, else the value returned before. 
+ * @param found - set to the rate when the display replied, else 0. 
+ * @return the step to continue with, 0 when the search is done. 
+ */
+uint8_t nexFindBaudStep(uint8_t step, uint32_t *found);
+
+/**
+ * Switches the link to a faster baudrate. 
+ *
+ * The display is switched with baud= and the link is verified by reading
+ * back the rate with "get baud". When that fails both sides return to the
+ * old rate and the next slower supported rate is tried, down to the
+ * current one. The rate that works is made the power on default of the
+ * display with bauds= and stored with nexSaveBaud(), so the next start
+ * opens the link at it. 
+ *
+ * @param baud - the rate wanted, a rate the display supports. 
+ * @return the rate of the link afterwards. 
+ *
+ * @warning Only in synchronous mode, see nexAsyncBegin(). 
+ */
+uint32_t nexNegotiateBaud(uint32_t baud);
 
 /**
  * Listen touch event and calling callbacks attached before.
  * 
- * Supports push and pop at present. 
+ * Processes all received bytes without waiting for the rest of a frame, 
+ * which is completed by a later call. Touch events are passed to the
+ * components in nex_listen_list, the other events to the handlers set with
+ * nexSetHandlers(). 
  *
  * @param nex_listen_list - index to Nextion Components list. 
  * @return none. 
@@ -45,6 +94,179 @@ bool nexInit(void);
  */
 void nexLoop(NexTouch *nex_listen_list[]);
 
+/**
+ * Event codes passed to a NexCodeHandler. 
+ */
+#define NEX_EVENT_STARTUP (0x00)   /* 0x00 0x00 0x00, display powered on */
+#define NEX_EVENT_SLEEP (0x86)     /* entered sleep mode */
+#define NEX_EVENT_WAKE (0x87)      /* woke up from sleep mode */
+#define NEX_EVENT_READY (0x88)     /* ready after power on or reset */
+#define NEX_EVENT_UPGRADE (0x89)   /* microSD upgrade started */
+#define NEX_EVENT_DATA_DONE (0xFD) /* transparent data finished */
+#define NEX_EVENT_DATA_READY (0xFE) /* ready for transparent data */
+
+typedef void (*NexPageHandler)(uint8_t pid);
+typedef void (*NexPositionHandler)(uint16_t x, uint16_t y, bool press, bool sleeping);
+typedef void (*NexCodeHandler)(uint8_t code);
+typedef void (*NexNumberHandler)(uint32_t number);
+typedef void (*NexStringHandler)(const char *str, uint16_t len);
+
+/**
+ * Handlers of the frames the display sends by itself. Any of them may be
+ * NULL, the frame is then only counted. 
+ */
+struct NexHandlers
+{
+    NexPageHandler page;         /* 0x66 page id, on sendme or a page change */
+    NexPositionHandler position; /* 0x67 and, while sleeping, 0x68 */
+    NexCodeHandler event;        /* startup, sleep, wake, ready etc. */
+    NexCodeHandler error;        /* a result code no command waits for */
+    NexNumberHandler number;     /* 0x71 sent with print */
+    NexStringHandler string;     /* 0x70 sent with prints, NEX_RX_STRING max */
+};
+
+/**
+ * Counters of the receiver of nexLoop() and nexAsyncPoll(). 
+ */
+struct NexRxStats
+{
+    uint32_t frames;         /* complete frames received */
+    uint32_t dispatched;     /* passed to a handler or touch component */
+    uint32_t invalid;        /* frames without a valid end, skipped */
+};
+
+/**
+ * Sets the handlers of the events and replies nobody waits for.
+ *
+ * @param handlers - the handlers, must stay valid, NULL for none. 
+ */
+void nexSetHandlers(const NexHandlers *handlers);
+
+const NexRxStats &nexRxStats(void);
+
+/**
+ * Return code passed to a completion callback when the display didn't
+ * reply within NEX_ASYNC_TIMEOUT.
+ */
+#define NEX_RET_ASYNC_TIMEOUT (0xFF)
+
+/**
+ * Called when the reply to an asynchronous command is received.
+ *
+ * @param ok - true if the display replied with 0x01.
+ * @param code - the return code of the display or NEX_RET_ASYNC_TIMEOUT.
+ * @param ptr - the pointer given with the command.
+ */
+typedef void (*NexCompletion)(bool ok, uint8_t code, void *ptr);
+
+/**
+ * Counters of the asynchronous commands.
+ */
+struct NexAsyncStats
+{
+    uint32_t sent;       /* commands written */
+    uint32_t acked;      /* replied with 0x01 */
+    uint32_t failed;     /* replied with an error code */
+    uint32_t timeouts;   /* no reply within NEX_ASYNC_TIMEOUT */
+    uint32_t stalls;     /* sends which had to wait for a free window */
+    uint32_t unexpected; /* replies without an outstanding command */
+    uint32_t resyncs;    /* markers sent to resynchronise after a timeout */
+    uint32_t dropped;    /* late replies dropped while resynchronising */
+    uint8_t maxPending;  /* most commands in flight at the same time */
+};
+
+/**
+ * Switches to asynchronous commands. 
+ *
+ * The display is set to bkcmd=3 so it replies to every command. From now on
+ * sendCommand() writes a command without waiting and recvRetCommandFinished()
+ * returns true at once; the replies are matched to the commands in FIFO order
+ * by nexAsyncPoll(). A "get" or "sendme" first waits for all outstanding
+ * replies, so the getters keep working synchronously. 
+ *
+ * @param window - max nr of commands in flight, up to NEX_ASYNC_QUEUE. 
+ * @return true if the display accepted bkcmd=3.
+ */
+bool nexAsyncBegin(uint8_t window);
+
+/**
+ * Waits for the outstanding replies and returns to synchronous commands.
+ */
+void nexAsyncEnd(void);
+
+/**
+ * Writes a command without waiting for its reply. Only blocks if the window
+ * of commands in flight is full. 
+ *
+ * @param cmd - the command, without the 0xFF 0xFF 0xFF terminator. 
+ * @param callback - called with the reply, may be NULL. 
+ * @param ptr - passed to the callback. 
+ * @return false if not in asynchronous mode.
+ */
+bool nexAsyncSend(const char *cmd, NexCompletion callback = NULL, void *ptr = NULL);
+
+/**
+ * Processes the received replies and calls the completion callbacks of the
+ * commands they belong to. Touch events are passed to the components in
+ * nex_listen_list, if given. Never blocks. 
+ *
+ * The replies are matched in FIFO order, so a reply arriving after its
+ * command timed out would be taken for the reply to the next one. After a
+ * timeout all commands in flight fail with NEX_RET_ASYNC_TIMEOUT and
+ * "get <marker>" is sent; the result codes are dropped until the display
+ * echoes the marker, which is sent again if it doesn't within
+ * NEX_ASYNC_TIMEOUT. Commands sent in the meantime are matched after it. 
+ *
+ * @param nex_listen_list - index to Nextion Components list, may be NULL. 
+ */
+void nexAsyncPoll(NexTouch *nex_listen_list[] = NULL);
+
+/**
+ * Polls until all outstanding commands have their reply or timed out, and
+ * at most NEX_ASYNC_TIMEOUT for the marker after a timeout, see
+ * nexAsyncPoll().
+ */
+void nexAsyncDrain(void);
+
+/**
+ * @return the nr of commands waiting for their reply.
+ */
+uint8_t nexAsyncPending(void);
+
+const NexAsyncStats &nexAsyncStats(void);
+
+/**
+ * Counters of the commands written to the display.
+ */
+struct NexTxStats
+{
+    uint32_t commands; /* commands written */
+    uint32_t bytes;    /* bytes written, terminators included */
+    uint32_t writes;   /* write calls to nexSerial */
+    uint32_t batches;  /* nexBatchEnd() calls which wrote something */
+};
+
+/**
+ * Starts collecting commands. 
+ *
+ * Until nexBatchEnd() the commands given to sendCommand() are only added,
+ * with their terminator, to a buffer of NEX_TX_BUFFER bytes, which is written
+ * with a single write when it is full or the batch ends. A command is always
+ * written in one write, also outside a batch. 
+ *
+ * @warning In synchronous mode recvRetCommandFinished() has to write the
+ *  batch to wait for the reply, so a batch only saves writes in
+ *  asynchronous mode, see nexAsyncBegin(). 
+ */
+void nexBatchBegin(void);
+
+/**
+ * Writes the collected commands and stops collecting.
+ */
+void nexBatchEnd(void);
+
+const NexTxStats &nexTxStats(void);
+
 /**
  * @}
  */
@@ -22,6 +22,55 @@
  * @{ 
  */
 
+/**
+ * Describes an attribute of a component, like "bco" or "txt". 
+ *
+ * The type of the value (uint32_t or const char *) and whether the component
+ * has to be redrawn with "ref" after a set are part of the type, so the
+ * compiler picks the matching accessor of NexObject and a string can't be
+ * assigned to a numeric attribute. 
+ */
+template <typename T, bool REF>
+struct NexAttribute
+{
+    const char *name;
+};
+
+typedef NexAttribute<uint32_t, false> NexNumAttr;      /* numeric */
+typedef NexAttribute<uint32_t, true> NexRefNumAttr;    /* numeric, ref after set */
+typedef NexAttribute<const char *, false> NexTextAttr; /* string */
+
+/**
+ * An attribute value remembered by the shadow cache of a component. 
+ */
+struct NexShadowEntry
+{
+    const char *attr;    /* name of the attribute, NULL if unused */
+    uint32_t value;      /* the number, or the hash of a string */
+    uint32_t generation; /* only valid in the generation it was stored in */
+};
+
+/**
+ * Counters of the shadow caches of all components. 
+ */
+struct NexShadowStats
+{
+    uint32_t hits;          /* gets answered from a cache */
+    uint32_t skippedWrites; /* sets of a value the display already has */
+    uint32_t invalidations; /* caches dropped by a page change or failure */
+};
+
+/**
+ * Counters of the redraw transactions. 
+ */
+struct NexRedrawStats
+{
+    uint32_t transactions; /* commitRedraw() calls */
+    uint32_t deferred;     /* refs not sent right after a set */
+    uint32_t refs;         /* refs sent by commitRedraw() */
+    uint32_t overflows;    /* refs sent right away, too many components */
+};
+
 /**
  * Root class of all Nextion components. 
  *
@@ -49,6 +98,60 @@ public: /* methods */
      */
     void printObjInfo(void);
 
+    /**
+     * Attach a shadow cache to the component. 
+     *
+     * The cache remembers the last value written to or read from every
+     * attribute, up to count attributes. A set of the value the display
+     * already has is skipped, also its ref, and a get of a numeric attribute
+     * is answered from the cache. Strings are remembered by their hash, so
+     * they are only used to skip writes. 
+     *
+     * @param entries - storage of the cache, count entries. 
+     * @param count - nr of attributes remembered. 
+     *
+     * @warning only use it for attributes the HMI doesn't change itself,
+     *  or call invalidateShadow() when it may have. 
+     */
+    void attachShadow(NexShadowEntry *entries, uint8_t count);
+
+    /**
+     * Forget the cached values of this component. 
+     */
+    void invalidateShadow(void);
+
+    /**
+     * Forget the cached values of all components. Called on a page change,
+     * because the display reloads the attributes of the new page, and when
+     * the display rejects a command. 
+     */
+    static void invalidateAllShadows(void);
+
+    static const NexShadowStats &shadowStats(void);
+
+    /**
+     * Start a redraw transaction. 
+     *
+     * Until commitRedraw() a set of a color, font etc. doesn't send the
+     * "ref <name>" redrawing the component. The component is marked dirty
+     * instead, so a theme change of several attributes costs one redraw per
+     * component. At most NEX_REDRAW_MAX components are collected, the refs
+     * of any others are sent right away. 
+     *
+     * @warning transactions don't nest, and the dirty components have to
+     *  be on the current page at commit. 
+     */
+    static void beginRedraw(void);
+
+    /**
+     * End the redraw transaction and send one ref per dirty component. 
+     *
+     * @return true if all refs succeeded, false for failure. 
+     */
+    static bool commitRedraw(void);
+
+    static const NexRedrawStats &redrawStats(void);
+
 protected: /* methods */
 
     /*
@@ -71,11 +174,83 @@ protected: /* methods */
      * @return the name of component. 
      */
     const char *getObjName(void);    
+
+    /*
+     * Get a numeric attribute with "get <name>.<attribute>".
+     *
+     * @param attr - the attribute.
+     * @param number - receives the value.
+     * @return true if success, false for failure.
+     */
+    template <bool REF>
+    bool getAttr(const NexAttribute<uint32_t, REF> &attr, uint32_t *number)
+    {
+        return getNumberAttr(attr.name, number);
+    }
+
+    /*
+     * Set a numeric attribute, followed by "ref <name>" if REF is set.
+     *
+     * @param attr - the attribute.
+     * @param number - the value.
+     * @return true if success, false for failure.
+     */
+    template <bool REF>
+    bool setAttr(const NexAttribute<uint32_t, REF> &attr, uint32_t number)
+    {
+        return setNumberAttr(attr.name, number, REF);
+    }
+
+    /*
+     * Get a string attribute.
+     *
+     * @param attr - the attribute.
+     * @param buffer - receives the string.
+     * @param len - the size of buffer.
+     * @return the length of the string.
+     */
+    uint16_t getAttr(const NexTextAttr &attr, char *buffer, uint16_t len)
+    {
+        return getTextAttr(attr.name, buffer, len);
+    }
+
+    /*
+     * Set a string attribute.
+     *
+     * @param attr - the attribute.
+     * @param buffer - the string.
+     * @return true if success, false for failure.
+     */
+    bool setAttr(const NexTextAttr &attr, const char *buffer)
+    {
+        return setTextAttr(attr.name, buffer);
+    }
+
+private: /* methods */
+
+    /*
+     * The shared implementations of all attribute accessors.
+     */
+    bool getNumberAttr(const char *attr, uint32_t *number);
+    bool setNumberAttr(const char *attr, uint32_t number, bool ref);
+    uint16_t getTextAttr(const char *attr, char *buffer, uint16_t len);
+    bool setTextAttr(const char *attr, const char *buffer);
+    NexShadowEntry *findShadow(const char *attr);
+    void storeShadow(const char *attr, uint32_t value);
+    bool deferRef(void);
     
 private: /* data */ 
     uint8_t __pid; /* Page ID */
     uint8_t __cid; /* Component ID */
     const char *__name; /* An unique name */
+    NexShadowEntry *__shadow; /* shadow cache, NULL if not used */
+    uint8_t __shadow_count;
+    static uint32_t __shadow_generation;
+    static NexShadowStats __shadow_stats;
+    static bool __redraw_active;
+    static uint8_t __redraw_count;
+    static NexObject *__redraw_dirty[NEX_REDRAW_MAX];
+    static NexRedrawStats __redraw_stats;
 };
 /**
  * @}
@@ -53,8 +53,27 @@ typedef void (*NexTouchEventCb)(void *ptr);
 class NexTouch: public NexObject
 {
 public: /* static methods */    
+    /**
+     * Pass a touch event to the component in list with page id pid and
+     * component id cid. 
+     *
+     * The component is looked up in the index of list, which is built when
+     * list is passed for the first time. 
+     */
     static void iterate(NexTouch **list, uint8_t pid, uint8_t cid, int32_t event);
 
+    /**
+     * Build the index of the components in a listen list, a hash table on
+     * page and component id. 
+     *
+     * Call it again after the contents of the list have changed. 
+     *
+     * @param list - NULL terminated listen list. 
+     * @return true if the list is indexed, false if it is too long for
+     *  NEX_TOUCH_INDEX and will be walked. 
+     */
+    static bool buildIndex(NexTouch **list);
+
 public: /* methods */
 
     /**
@@ -101,12 +120,16 @@ public: /* methods */
 private: /* methods */ 
     void push(void);
     void pop(void);
+    static NexTouch *find(NexTouch **list, uint8_t pid, uint8_t cid);
     
 private: /* data */ 
     NexTouchEventCb __cb_push;
     void *__cbpush_ptr;
     NexTouchEventCb __cb_pop;
     void *__cbpop_ptr;
+    static NexTouch *__index[NEX_TOUCH_INDEX];
+    static NexTouch **__index_list; /* the list indexed */
+    static bool __index_used;       /* false if the list is walked */
 };
 
 /**
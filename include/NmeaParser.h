@@ -0,0 +1,136 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     NmeaParser.h
+  Purpose:  Streaming, zero-allocation NMEA0183 receiver which validates and
+            splits a sentence while it is being received.
+
+  NOTES:    The receiver is fed one byte at a time. Per byte it updates the
+            running XOR checksum and records the offset of every ',' so when
+            the end-of-line marker arrives the sentence is already split in
+            fields and there is no need to scan the buffer a second time.
+            Sentences with a wrong '*hh' checksum, a missing start delimiter
+            or more than 82 characters are dropped and counted.
+            Sentences without a checksum are accepted unless
+            NMEA_REQUIRE_CHECKSUM is defined.
+            Field 0 is the tag i.e. "$IIMWV", field 1 the first value etc.
+*/
+#ifndef __NMEAPARSER_H__
+#define __NMEAPARSER_H__
+
+#include <Arduino.h>
+
+//#define NMEA_REQUIRE_CHECKSUM 1 // out comment to drop sentences without '*hh'
+
+#define NMEA_BUFFER_SIZE 83 // According NEA0183 specs the max char is 82 + '\0'
+#define NMEA_MAX_FIELDS 24  // 82 char sentence can't hold more meaningful fields
+
+/*** Packs a 3 char sentence id like 'M','W','V' in one 32 bit value so sentence
+ * types can be compared and looked up with a single integer compare
+ */
+#define NMEA_ID(a, b, c) (((uint32_t)(uint8_t)(a) << 16) | ((uint32_t)(uint8_t)(b) << 8) | (uint32_t)(uint8_t)(c))
+
+/*** A single field in a received sentence; not '\0' terminated!
+*/
+struct NmeaField
+{
+  const char *ptr;
+  uint8_t len;
+};
+
+/*** A received, validated and pre-split sentence.
+ * data holds the sentence from '$' up to the checksum, without <CR><LF>
+ */
+struct NmeaSentence
+{
+  char data[NMEA_BUFFER_SIZE];
+  uint8_t len;
+  uint8_t nrOfFields;
+  uint8_t fieldStart[NMEA_MAX_FIELDS + 1]; // [nrOfFields] is one past the last field
+  uint32_t id;                             // packed sentence id of the tag, see NMEA_ID
+
+  /*** Returns field i as span into data; an empty field if i is out of range
+   */
+  NmeaField field(uint8_t i) const;
+};
+
+/*** Handler called for a sentence type listed in a dispatch table
+*/
+typedef void (*NmeaHandler)(const NmeaSentence &sentence);
+
+struct NmeaDispatch
+{
+  uint32_t id; // NMEA_ID of the sentence
+  NmeaHandler handler;
+};
+
+/*** Counters kept by the receiver, mainly for performance tuning
+*/
+struct NmeaStats
+{
+  uint32_t sentences;      // valid sentences delivered
+  uint32_t checksumErrors; // dropped due to a wrong checksum
+  uint32_t overflows;      // dropped because longer than 82 characters
+  uint32_t unchecked;      // sentences received without a checksum
+};
+
+class NmeaReceiver
+{
+public:
+  NmeaReceiver();
+
+  /*** Sets the buffer the next sentence is received in.
+   */
+  void setBuffer(NmeaSentence *buffer);
+
+  /*** Processes one received byte.
+   * @return true when the buffer holds a complete and valid sentence
+   */
+  bool feed(char c);
+
+  /*** Returns true if the receiver is waiting for the start of a sentence
+   */
+  bool idle() const { return _state == WAIT_START; }
+
+  const NmeaSentence *buffer() const { return _buf; }
+  const NmeaStats &stats() const { return _stats; }
+
+private:
+  enum State
+  {
+    WAIT_START,
+    IN_DATA,
+    IN_CHECKSUM_HI,
+    IN_CHECKSUM_LO,
+    WAIT_EOL
+  };
+
+  bool complete();
+  void store(char c);
+
+  NmeaSentence *_buf;
+  State _state;
+  uint8_t _checksum;
+  uint8_t _received;
+  bool _hasChecksum;
+  NmeaStats _stats;
+};
+
+/*** Calls the handler registered in table for the id of sentence.
+ * The table is a small constant array so lookup is a bounded number of
+ * integer compares, independent of the sentence length or its content.
+ * @return true if a handler was found
+ */
+bool nmeaDispatch(const NmeaSentence &sentence, const NmeaDispatch *table, uint8_t count);
+
+/*** Copies a field into dst as a '\0' terminated string and truncates it
+ * to size - 1 characters.
+ */
+void nmeaFieldCopy(const NmeaField &field, char *dst, uint8_t size);
+
+/*** Parses a decimal field like "-12.34" in tenths, rounded at the second
+ * decimal, so values can be kept as integers i.e. -123.
+ * @return false if the field is empty, out of range or not a number
+ */
+bool nmeaFieldTenths(const NmeaField &field, int32_t *tenths);
+
+#endif /* #ifndef __NMEAPARSER_H__ */
@@ -0,0 +1,90 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     NmeaRelay.h
+  Purpose:  Forwards the received NMEA0183 sentences to the next device in
+            the daisy chain within the bandwidth of the output link.
+
+  NOTES:    A sentence is written straight from its slot in the receive
+            ring, so it is never copied. The output is paced by a token
+            bucket which fills with the byte rate of the link, 480 bytes/s
+            at 4800 Bd; a sentence that doesn't fit is dropped, never
+            delayed, so the receiver can't fall behind on a saturated link.
+            The bucket holds at most the burst, which is kept at the size
+            of the UART TX FIFO so a write never blocks. That only holds
+            for a hardware UART; SoftwareSerial sends every byte while the
+            caller waits, so don't relay on it.
+            Every sentence type has a priority, 0 the highest. A sentence
+            of priority p may only use the bucket if after sending it
+            p * reserve bytes are left, so the lower priorities can't take
+            the bytes of a wind sentence arriving right after them.
+            The priorities only decide what is dropped, the sentences are
+            not queued per priority and never reordered: they go out in the
+            order they were received, or not at all. On a saturated link
+            the lower priorities are dropped first.
+*/
+#ifndef __NMEARELAY_H__
+#define __NMEARELAY_H__
+
+#include <Arduino.h>
+#include "NmeaParser.h"
+
+#define NMEA_RELAY_PRIORITIES 4 // nr of priorities, 0 is the highest
+
+/*** Priority of a sentence type, see NMEA_ID
+*/
+struct NmeaRelayRoute
+{
+  uint32_t id;
+  uint8_t priority;
+};
+
+/*** Counters of the relay per priority
+*/
+struct NmeaRelayStats
+{
+  uint32_t relayed[NMEA_RELAY_PRIORITIES]; // sentences written
+  uint32_t dropped[NMEA_RELAY_PRIORITIES]; // sentences that didn't fit the budget
+  uint32_t bytes;                          // bytes written, <CR><LF> included
+};
+
+class NmeaRelay
+{
+public:
+  /*** bytesPerSecond is the rate of the output link, burst the most bytes
+   * written at once and reserve the bytes kept free per priority above
+   */
+  NmeaRelay(uint32_t bytesPerSecond, uint16_t burst, uint16_t reserve);
+
+  /*** Sets the priorities of the sentence types. Types not in the table
+   * get the lowest priority.
+   */
+  void setRoutes(const NmeaRelayRoute *routes, uint8_t count);
+
+  /*** Changes the byte rate, i.e. after the baudrate of the output changed
+   */
+  void setRate(uint32_t bytesPerSecond) { _rate = bytesPerSecond; }
+
+  /*** Writes the sentence with <CR><LF> to out if it fits in the budget
+   * of its priority.
+   * @return false if it is dropped
+   */
+  bool relay(const NmeaSentence &sentence, Print &out);
+
+  const NmeaRelayStats &stats() const { return _stats; }
+  void resetStats();
+
+private:
+  uint8_t priority(uint32_t id) const;
+  void refill();
+
+  const NmeaRelayRoute *_routes;
+  uint8_t _nrOfRoutes;
+  uint32_t _rate;
+  uint32_t _burst;       // in milli bytes like the credit
+  uint32_t _reserve;     // in milli bytes like the credit
+  uint32_t _credit;      // milli bytes that may be written now
+  unsigned long _lastUs; // micros() at the last refill
+  NmeaRelayStats _stats;
+};
+
+#endif /* #ifndef __NMEARELAY_H__ */
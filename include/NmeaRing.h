@@ -0,0 +1,60 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     NmeaRing.h
+  Purpose:  Lock-free ring of completed NMEA sentences between the receiver
+            and the parser.
+
+  NOTES:    Single producer (recvNMEAData) and single consumer
+            (processNMEAData) only. The receiver writes directly into the
+            free slot at the head, so a sentence is never copied. When all
+            slots are in use the producer gets a spare slot instead; a
+            sentence received in the spare slot is dropped and counted as
+            an overflow, so the receiver never stalls on a busy display.
+*/
+#ifndef __NMEARING_H__
+#define __NMEARING_H__
+
+#include <Arduino.h>
+#include "NmeaParser.h"
+
+#define NMEA_RING_SIZE 8 // nr of sentence slots, must be a power of 2
+
+class NmeaRing
+{
+public:
+  NmeaRing();
+
+  /*** Returns the slot the producer has to receive the next sentence in.
+   * This is the spare slot if the ring is full.
+   */
+  NmeaSentence *producerSlot();
+
+  /*** Publishes the sentence in the producer slot to the consumer.
+   * @return false if it was received in the spare slot and is dropped
+   */
+  bool push();
+
+  /*** Returns the oldest published sentence or NULL if the ring is empty.
+   * The slot stays valid until release() is called.
+   */
+  NmeaSentence *peek();
+
+  /*** Returns the slot obtained with peek() to the producer
+   */
+  void release();
+
+  uint8_t count() const;
+  uint8_t highWater() const { return _highWater; }
+  uint32_t overflows() const { return _overflows; }
+
+private:
+  NmeaSentence _slots[NMEA_RING_SIZE];
+  NmeaSentence _spare;
+  NmeaSentence *_producing;
+  volatile uint8_t _head; // written by producer only
+  volatile uint8_t _tail; // written by consumer only
+  uint8_t _highWater;
+  uint32_t _overflows;
+};
+
+#endif /* #ifndef __NMEARING_H__ */
@@ -0,0 +1,95 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     SerialTransport.h
+  Purpose:  Small Stream-like interface for every serial link used by the
+            firmware: the NMEA input, the Nextion display and debug output.
+
+  NOTES:    A transport is an Arduino Stream which also knows how to open
+            itself with a baud rate, so NexHardware.cpp and main.cpp never
+            refer to Serial2, Serial or SoftwareSerial directly and the same
+            code runs on the ESP32 and, with NATIVE_BUILD defined, on Linux.
+            The pins, inversion etc. are given when the transport is created.
+            The Linux implementation lives in src/native.
+*/
+#ifndef __SERIALTRANSPORT_H__
+#define __SERIALTRANSPORT_H__
+
+#include <Arduino.h>
+
+class SerialTransport : public Stream
+{
+public:
+  /*** Opens the link with the given baudrate, may be called again to
+   * change the baudrate of an opened link
+   */
+  virtual void begin(uint32_t baud) = 0;
+
+  /*** Returns the baudrate set with begin()
+   */
+  virtual uint32_t baudRate() = 0;
+
+  using Print::write;
+};
+
+#ifndef NATIVE_BUILD
+#include <HardwareSerial.h>
+#include <SoftwareSerial.h>
+
+/*** One of the ESP32 hardware UARTs, Serial, Serial1 or Serial2
+*/
+class UartTransport : public SerialTransport
+{
+public:
+  UartTransport(HardwareSerial &uart, int8_t rxPin = -1, int8_t txPin = -1, bool invert = false);
+
+  /*** Size of the receive buffer the UART driver fills from its FIFO in the
+   * background; only used by the first begin()
+   */
+  void setRxBufferSize(size_t size) { _rxBufferSize = size; }
+
+  void begin(uint32_t baud);
+  uint32_t baudRate();
+
+  int available() { return _uart.available(); }
+  int read() { return _uart.read(); }
+  int peek() { return _uart.peek(); }
+  void flush() { _uart.flush(); }
+  size_t write(uint8_t c) { return _uart.write(c); }
+  size_t write(const uint8_t *buffer, size_t size) { return _uart.write(buffer, size); }
+
+private:
+  HardwareSerial &_uart;
+  int8_t _rxPin;
+  int8_t _txPin;
+  bool _invert;
+  uint32_t _baud;
+  size_t _rxBufferSize;
+};
+
+/*** EspSoftwareSerial on any pair of GPIO pins
+*/
+class SoftSerialTransport : public SerialTransport
+{
+public:
+  SoftSerialTransport(SoftwareSerial &serial, int8_t rxPin, int8_t txPin, bool invert = false);
+
+  void begin(uint32_t baud);
+  uint32_t baudRate();
+
+  int available() { return _serial.available(); }
+  int read() { return _serial.read(); }
+  int peek() { return _serial.peek(); }
+  void flush() { _serial.flush(); }
+  size_t write(uint8_t c) { return _serial.write(c); }
+  size_t write(const uint8_t *buffer, size_t size) { return _serial.write(buffer, size); }
+
+private:
+  SoftwareSerial &_serial;
+  int8_t _rxPin;
+  int8_t _txPin;
+  bool _invert;
+  uint32_t _baud;
+};
+#endif
+
+#endif /* #ifndef __SERIALTRANSPORT_H__ */
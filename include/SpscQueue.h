@@ -0,0 +1,72 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     SpscQueue.h
+  Purpose:  Fixed size lock-free queue for exactly one producer and one
+            consumer, which may run on different cores.
+
+  NOTES:    Items are copied in and out, so keep them small. Size must be
+            a power of 2 and at most 128. The producer only writes _head,
+            the consumer only writes _tail; a memory barrier makes sure the
+            item is visible before the index that publishes it.
+*/
+#ifndef __SPSCQUEUE_H__
+#define __SPSCQUEUE_H__
+
+#include <Arduino.h>
+
+template <typename T, uint8_t SIZE>
+class SpscQueue
+{
+public:
+  SpscQueue() : _head(0), _tail(0), _highWater(0), _drops(0) {}
+
+  /*** Adds item to the queue
+   * @return false if the queue is full and the item is dropped
+   */
+  bool push(const T &item)
+  {
+    uint8_t n = (uint8_t)(_head - _tail);
+    if (n >= SIZE)
+    {
+      _drops++;
+      return false;
+    }
+    _items[_head & (SIZE - 1)] = item;
+    __sync_synchronize();
+    _head = _head + 1;
+    if (n + 1 > _highWater)
+    {
+      _highWater = n + 1;
+    }
+    return true;
+  }
+
+  /*** Removes the oldest item from the queue
+   * @return false if the queue is empty
+   */
+  bool pop(T &item)
+  {
+    if (_head == _tail)
+    {
+      return false;
+    }
+    __sync_synchronize();
+    item = _items[_tail & (SIZE - 1)];
+    __sync_synchronize();
+    _tail = _tail + 1;
+    return true;
+  }
+
+  uint8_t count() const { return (uint8_t)(_head - _tail); }
+  uint8_t highWater() const { return _highWater; }
+  uint32_t drops() const { return _drops; }
+
+private:
+  T _items[SIZE];
+  volatile uint8_t _head;
+  volatile uint8_t _tail;
+  uint8_t _highWater;
+  uint32_t _drops;
+};
+
+#endif /* #ifndef __SPSCQUEUE_H__ */
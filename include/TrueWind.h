@@ -0,0 +1,98 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     TrueWind.h
+  Purpose:  Fixed-point calculation of the true wind from the apparent wind
+            and the speed and course of the boat.
+
+  NOTES:    Everything is calculated on the values in tenths as they are
+            kept in NavState, with 32 bit integers only. The ESP32 FPU only
+            does single precision and a double cos() or sqrt() is emulated
+            in software, so the integer kernel is faster and gives the same
+            result on the ESP32 and in the native build.
+            Sine and arctangent come from small const tables, which the
+            ESP32 keeps in flash, and are interpolated linearly; the square
+            root is an integer one.
+            The true wind vector is the apparent wind minus the boat speed:
+              x = AWS * cos(AWA) - SOG, y = AWS * sin(AWA)
+              TWS = sqrt(x^2 + y^2), TWA = atan2(y, x), TWD = COG + TWA
+            like the Starpath TrueWind formula of David Burch, 2000. The
+            COG stands in for the heading, there is no compass. TWA is
+            negative to port like the AWA.
+            VMG = SOG * cos(TWA) = SOG * x / TWS comes from the same vector,
+            so the sine and cosine of the AWA are shared by all outputs.
+            The wind history keeps the true wind of the last TW_HISTORY
+            samples as unit vectors, so the mean direction doesn't jump
+            around north; the sums of the vectors are updated per sample
+            instead of adding all samples again.
+*/
+#ifndef __TRUEWIND_H__
+#define __TRUEWIND_H__
+
+#include <Arduino.h>
+
+#define TW_MAX_SPEED 1800 // tenths of knots, faster input is clipped
+#define TW_HISTORY 30     // samples in the wind history, at most 64
+
+/*** True wind in tenths of knots and degrees
+*/
+struct TrueWind
+{
+  int32_t tws; // 0..TW_MAX_SPEED * 2
+  int16_t twa; // -1800..1800, negative is port
+  int16_t twd; // 0..3599
+  int32_t vmg; // towards the wind, negative when running
+};
+
+/*** Sine and cosine of an angle in tenths of degrees, any value, as Q15
+ * (32767 is 1.0)
+ */
+int16_t twSin(int32_t tenths);
+int16_t twCos(int32_t tenths);
+
+/*** Angle of the vector x,y in tenths of degrees, -1800..1800, 0 if both
+ * are 0; |x| and |y| must be below 2^19
+ */
+int16_t twAtan2(int32_t y, int32_t x);
+
+/*** Integer square root, rounded down
+ */
+uint16_t twSqrt(uint32_t value);
+
+/*** Calculates the true wind from AWS, AWA, SOG and COG in tenths
+ */
+void twCalculate(int32_t aws, int32_t awa, int32_t sog, int32_t cog, TrueWind *tw);
+
+/*** The true wind of the last TW_HISTORY samples
+*/
+class WindHistory
+{
+public:
+  WindHistory();
+
+  /*** Adds a sample of TWS and TWD in tenths, the oldest is dropped when
+   * the history is full
+   */
+  void add(int32_t tws, int32_t twd);
+  void clear();
+
+  uint8_t count() const { return _count; }
+
+  /*** Returns the mean TWD in tenths, 0..3599
+   */
+  int16_t meanDirection() const;
+
+  /*** Returns the highest TWS in tenths
+   */
+  int32_t maxSpeed() const;
+
+private:
+  int32_t _tws[TW_HISTORY];
+  int16_t _x[TW_HISTORY]; // cos(TWD) as Q15
+  int16_t _y[TW_HISTORY]; // sin(TWD) as Q15
+  int32_t _sumX;
+  int32_t _sumY;
+  uint8_t _head;
+  uint8_t _count;
+};
+
+#endif /* #ifndef __TRUEWIND_H__ */
@@ -0,0 +1,109 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     HmiFrame.cpp
+  Purpose:  Implementation of the delta encoder of the HMI frames
+*/
+#include "HmiFrame.h"
+
+//*** a value in the frame to the HMI, shown as placeholder while not valid
+struct FrameField
+{
+  uint8_t key;
+  const char *tag;
+  const char *placeholder;
+};
+
+//*** the fields in the order they are send in a frame
+static const FrameField frameFields[] = {
+    {NAV_COG, "COG=", "---.-"},
+    {NAV_AWA, "AWA=", "--.-"},
+    {NAV_SOG, "SOG=", "--.-"},
+    {NAV_AWS, "AWS=", "--.-"},
+    {NAV_BAT, "BAT=", "--.-"},
+    {NAV_DPT, "DPT=", "--.-"},
+    {NAV_TWS, "TWS=", "--.-"},
+    {NAV_TWA, "TWA=", "--.-"},
+    {NAV_TWD, "TWD=", "---.-"},
+    {NAV_VMG, "VMG=", "--.-"},
+    {NAV_MWD, "MWD=", "---.-"},
+    {NAV_MXW, "MXW=", "--.-"},
+};
+
+#define NR_OF_FIELDS (sizeof(frameFields) / sizeof(frameFields[0]))
+
+HmiFrame::HmiFrame() : _refreshDue(true), _lastRefresh(0)
+{
+  memset(_sent, 0, sizeof(_sent));
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+/*** Appends "<tag><value>#" to p and returns the new end
+*/
+static char *appendField(char *p, const FrameField &field, const NavState &state)
+{
+  size_t len = strlen(field.tag);
+  memcpy(p, field.tag, len);
+  p += len;
+  if (state.valid(field.key))
+  {
+    p += navFormatTenths(state.tenths(field.key), p);
+  }
+  else
+  {
+    len = strlen(field.placeholder);
+    memcpy(p, field.placeholder, len);
+    p += len;
+  }
+  *p++ = '#';
+  return p;
+}
+
+uint8_t HmiFrame::encode(const NavState &state, unsigned long now, char *dst)
+{
+  char *p = dst;
+  uint8_t fullLen = 0;
+  uint8_t keys = 0;
+  bool full = _refreshDue || now - _lastRefresh >= HMI_FRAME_REFRESH;
+
+  for (uint8_t i = 0; i < NR_OF_FIELDS; i++)
+  {
+    const FrameField &field = frameFields[i];
+    Sent &sent = _sent[field.key];
+    if (!full && !(state.dirty() & NAV_BIT(field.key)))
+    {
+      // not changed since the last frame, nothing to compare
+      fullLen += sent.len;
+      continue;
+    }
+    bool valid = state.valid(field.key);
+    int32_t tenths = valid ? state.tenths(field.key) : 0;
+
+    if (full || valid != sent.valid || tenths != sent.tenths)
+    {
+      char *start = p;
+      p = appendField(p, field, state);
+      sent.valid = valid;
+      sent.tenths = tenths;
+      sent.len = p - start;
+      keys++;
+    }
+    fullLen += sent.len;
+  }
+  *p = '\0';
+
+  if (full)
+  {
+    _refreshDue = false;
+    _lastRefresh = now;
+    _stats.fullFrames++;
+  }
+  if (keys == 0)
+  {
+    return 0;
+  }
+  _stats.frames++;
+  _stats.keys += keys;
+  _stats.bytes += p - dst;
+  _stats.fullBytes += fullLen;
+  return p - dst;
+}
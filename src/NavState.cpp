@@ -0,0 +1,78 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     NavState.cpp
+  Purpose:  Implementation of the navigation value store
+*/
+#include "NavState.h"
+
+NavState::NavState() : _valid(0), _dirty(0), _nodes(NULL), _nrOfNodes(0), _derivations(0)
+{
+  memset(_tenths, 0, sizeof(_tenths));
+}
+
+void NavState::set(uint8_t key, int32_t tenths)
+{
+  if (!valid(key) || _tenths[key] != tenths)
+  {
+    _dirty |= (1 << key);
+  }
+  _tenths[key] = tenths;
+  _valid |= (1 << key);
+}
+
+void NavState::invalidate(uint8_t key)
+{
+  if (valid(key))
+  {
+    _dirty |= (1 << key);
+  }
+  _valid &= ~(1 << key);
+}
+
+void NavState::setNodes(const NavNode *nodes, uint8_t count)
+{
+  _nodes = nodes;
+  _nrOfNodes = count;
+}
+
+void NavState::derive()
+{
+  // the outputs a node sets are dirty for the nodes after it
+  for (uint8_t i = 0; i < _nrOfNodes; i++)
+  {
+    if (_dirty & _nodes[i].inputs)
+    {
+      _nodes[i].derive(*this);
+      _derivations++;
+    }
+  }
+}
+
+uint8_t navFormatTenths(int32_t tenths, char *dst)
+{
+  char digits[NAV_TEXT_SIZE];
+  uint8_t n = 0;
+  uint8_t len = 0;
+  uint32_t value = tenths < 0 ? -(uint32_t)tenths : (uint32_t)tenths;
+
+  // reversed: decimal, point and at least 1 integer digit
+  digits[n++] = '0' + value % 10;
+  digits[n++] = '.';
+  value /= 10;
+  do
+  {
+    digits[n++] = '0' + value % 10;
+    value /= 10;
+  } while (value > 0);
+
+  if (tenths < 0)
+  {
+    dst[len++] = '-';
+  }
+  while (n > 0)
+  {
+    dst[len++] = digits[--n];
+  }
+  dst[len] = '\0';
+  return len;
+}
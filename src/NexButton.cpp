@@ -15,6 +15,19 @@
 
 #include "NexButton.h"
 
+static const NexTextAttr __txt = {"txt"};
+static const NexRefNumAttr __bco = {"bco"};
+static const NexRefNumAttr __bco2 = {"bco2"};
+static const NexRefNumAttr __pco = {"pco"};
+static const NexRefNumAttr __pco2 = {"pco2"};
+static const NexRefNumAttr __xcen = {"xcen"};
+static const NexRefNumAttr __ycen = {"ycen"};
+static const NexRefNumAttr __font = {"font"};
+static const NexRefNumAttr __picc = {"picc"};
+static const NexRefNumAttr __picc2 = {"picc2"};
+static const NexRefNumAttr __pic = {"pic"};
+static const NexRefNumAttr __pic2 = {"pic2"};
+
 NexButton::NexButton(uint8_t pid, uint8_t cid, const char *name)
     :NexTouch(pid, cid, name)
 {
@@ -22,330 +35,121 @@ NexButton::NexButton(uint8_t pid, uint8_t cid, const char *name)
 
 uint16_t NexButton::getText(char *buffer, uint16_t len)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".txt";
-    sendCommand(cmd.c_str());
-    return recvRetString(buffer,len);
+    return getAttr(__txt, buffer, len);
 }
 
 bool NexButton::setText(const char *buffer)
 {
-    String cmd;
-    cmd += getObjName();
-    cmd += ".txt=\"";
-    cmd += buffer;
-    cmd += "\"";
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();    
+    return setAttr(__txt, buffer);
 }
 
 
 uint32_t NexButton::Get_background_color_bco(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".bco";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__bco, number);
 }
 
 bool NexButton::Set_background_color_bco(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".bco=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd="";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__bco, number);
 }
 
 uint32_t NexButton::Get_press_background_color_bco2(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".bco2";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__bco2, number);
 }
 
 bool NexButton::Set_press_background_color_bco2(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".bco2=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd="";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__bco2, number);
 }
 
 uint32_t NexButton::Get_font_color_pco(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".pco";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pco, number);
 }
 
 bool NexButton::Set_font_color_pco(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pco=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__pco, number);
 }
 
 uint32_t NexButton::Get_press_font_color_pco2(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".pco2";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pco2, number);
 }
 
 bool NexButton::Set_press_font_color_pco2(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pco2=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__pco2, number);
 }
 
 uint32_t NexButton::Get_place_xcen(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".xcen";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__xcen, number);
 }
 
 bool NexButton::Set_place_xcen(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".xcen=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__xcen, number);
 }
 
 uint32_t NexButton::Get_place_ycen(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".ycen";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__ycen, number);
 }
 
 bool NexButton::Set_place_ycen(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".ycen=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__ycen, number);
 }
 
 uint32_t NexButton::getFont(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".font";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__font, number);
 }
 
 bool NexButton::setFont(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".font=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__font, number);
 }
 
 uint32_t NexButton::Get_background_cropi_picc(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".picc";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__picc, number);
 }
 
 bool NexButton::Set_background_crop_picc(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".picc=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__picc, number);
 }
 
 uint32_t NexButton::Get_press_background_crop_picc2(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".picc2";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__picc2, number);
 }
 
 bool NexButton::Set_press_background_crop_picc2(uint32_t number)
 {
-	char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".picc2=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__picc2, number);
 }
 
 uint32_t NexButton::Get_background_image_pic(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".pic";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pic, number);
 }
 
 bool NexButton::Set_background_image_pic(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pic=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__pic, number);
 }
 
 uint32_t NexButton::Get_press_background_image_pic2(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".pic2";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pic2, number);
 }
 
 bool NexButton::Set_press_background_image_pic2(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pic2=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__pic2, number);
 }
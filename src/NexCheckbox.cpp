@@ -14,6 +14,10 @@
  */
 #include "NexCheckbox.h"
 
+static const NexNumAttr __val = {"val"};
+static const NexRefNumAttr __bco = {"bco"};
+static const NexRefNumAttr __pco = {"pco"};
+
 NexCheckbox::NexCheckbox(uint8_t pid, uint8_t cid, const char *name)
     :NexTouch(pid, cid, name)
 {
@@ -21,79 +25,30 @@ NexCheckbox::NexCheckbox(uint8_t pid, uint8_t cid, const char *name)
 
 uint32_t NexCheckbox::getValue(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".val";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__val, number);
 }
 
 bool NexCheckbox::setValue(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".val=";
-    cmd += buf;
-
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__val, number);
 }
 
 uint32_t NexCheckbox::Get_background_color_bco(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".bco";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__bco, number);
 }
 
 bool NexCheckbox::Set_background_color_bco(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".bco=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd="";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__bco, number);
 }
 
 uint32_t NexCheckbox::Get_font_color_pco(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".pco";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pco, number);
 }
 
 bool NexCheckbox::Set_font_color_pco(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pco=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__pco, number);
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+/**
+ * @file NexCommand.cpp
+ *
+ * The implementation of class NexCommand. 
+ *
+ * @copyright 
+ * Copyright (C) 2014-2015 ITEAD Intelligent Systems Co., Ltd. \n
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ */
+#include "NexCommand.h"
+
+uint32_t NexCommand::__overflows = 0;
+
+NexCommand::NexCommand(void)
+    :__len(0)
+{
+    __buf[0] = '\0';
+}
+
+NexCommand::NexCommand(const char *str)
+    :__len(0)
+{
+    __buf[0] = '\0';
+    *this += str;
+}
+
+NexCommand &NexCommand::operator=(const char *str)
+{
+    __len = 0;
+    __buf[0] = '\0';
+    return *this += str;
+}
+
+NexCommand &NexCommand::operator+=(const char *str)
+{
+    while (*str)
+    {
+        if (__len >= NEX_CMD_SIZE - 1)
+        {
+            __overflows++;
+            dbSerialPrintln("NexCommand overflow");
+            break;
+        }
+        __buf[__len++] = *str++;
+    }
+    __buf[__len] = '\0';
+    return *this;
+}
+
+NexCommand &NexCommand::operator+=(char c)
+{
+    char str[2] = {c, '\0'};
+    return *this += str;
+}
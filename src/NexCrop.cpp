@@ -15,6 +15,8 @@
 
 #include "NexCrop.h"
 
+static const NexNumAttr __picc = {"picc"};
+
 NexCrop::NexCrop(uint8_t pid, uint8_t cid, const char *name)
     :NexTouch(pid, cid, name)
 {
@@ -22,47 +24,21 @@ NexCrop::NexCrop(uint8_t pid, uint8_t cid, const char *name)
 
 bool NexCrop::Get_background_crop_picc(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".picc";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__picc, number);
 }
 
 bool NexCrop::Set_background_crop_picc(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".picc=";
-    cmd += buf;
-
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__picc, number);
 }
 
 bool NexCrop::getPic(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".picc";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__picc, number);
 }
 
 bool NexCrop::setPic(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".picc=";
-    cmd += buf;
-
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__picc, number);
 }
 
@@ -15,6 +15,19 @@
 
 #include "NexDualStateButton.h"
 
+static const NexNumAttr __val = {"val"};
+static const NexTextAttr __txt = {"txt"};
+static const NexRefNumAttr __bco0 = {"bco0"};
+static const NexRefNumAttr __bco1 = {"bco1"};
+static const NexRefNumAttr __pco = {"pco"};
+static const NexRefNumAttr __xcen = {"xcen"};
+static const NexRefNumAttr __ycen = {"ycen"};
+static const NexRefNumAttr __font = {"font"};
+static const NexRefNumAttr __picc0 = {"picc0"};
+static const NexRefNumAttr __picc1 = {"picc1"};
+static const NexRefNumAttr __pic0 = {"pic0"};
+static const NexRefNumAttr __pic1 = {"pic1"};
+
 NexDSButton::NexDSButton(uint8_t pid, uint8_t cid, const char *name)
     :NexTouch(pid, cid, name)
 {
@@ -22,326 +35,122 @@ NexDSButton::NexDSButton(uint8_t pid, uint8_t cid, const char *name)
 
 bool NexDSButton::getValue(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".val";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__val, number);
 }
 
 bool NexDSButton::setValue(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".val=";
-    cmd += buf;
-
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__val, number);
 }
 
 uint16_t NexDSButton::getText(char *buffer, uint16_t len)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".txt";
-    sendCommand(cmd.c_str());
-    return recvRetString(buffer,len);
+    return getAttr(__txt, buffer, len);
 }
 
 bool NexDSButton::setText(const char *buffer)
 {
-    String cmd;
-    cmd += getObjName();
-    cmd += ".txt=\"";
-    cmd += buffer;
-    cmd += "\"";
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();    
+    return setAttr(__txt, buffer);
 }
 
 uint32_t NexDSButton::Get_state0_color_bco0(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".bco0";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__bco0, number);
 }
 
 bool NexDSButton::Set_state0_color_bco0(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".bco0=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-
-    cmd="";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__bco0, number);
 }
 
 uint32_t NexDSButton::Get_state1_color_bco1(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".bco1";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__bco1, number);
 }
 
 bool NexDSButton::Set_state1_color_bco1(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".bco1=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd="";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__bco1, number);
 }
 
 uint32_t NexDSButton::Get_font_color_pco(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".pco";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pco, number);
 }
 
 bool NexDSButton::Set_font_color_pco(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pco=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__pco, number);
 }
 
 uint32_t NexDSButton::Get_place_xcen(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".xcen";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__xcen, number);
 }
 
 bool NexDSButton::Set_place_xcen(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".xcen=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__xcen, number);
 }
 
 uint32_t NexDSButton::Get_place_ycen(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".ycen";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__ycen, number);
 }
 
 bool NexDSButton::Set_place_ycen(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".ycen=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__ycen, number);
 }
 
 uint32_t NexDSButton::getFont(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".font";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__font, number);
 }
 
 bool NexDSButton::setFont(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".font=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__font, number);
 }
 
 uint32_t NexDSButton::Get_state0_crop_picc0(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".picc0";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__picc0, number);
 }
 
 bool NexDSButton::Set_state0_crop_picc0(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".picc0=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__picc0, number);
 }
 
 uint32_t NexDSButton::Get_state1_crop_picc1(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".picc1";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__picc1, number);
 }
 
 bool NexDSButton::Set_state1_crop_picc1(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".picc1=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__picc1, number);
 }
 
 uint32_t NexDSButton::Get_state0_image_pic0(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".pic0";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pic0, number);
 }
 
 bool NexDSButton::Set_state0_image_pic0(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pic0=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__pic0, number);
 }
 
 uint32_t NexDSButton::Get_state1_image_pic1(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".pic1";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pic1, number);
 }
 
 bool NexDSButton::Set_state1_image_pic1(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pic1=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__pic1, number);
 }
 
 
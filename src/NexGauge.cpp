@@ -15,6 +15,12 @@
 
 #include "NexGauge.h"
 
+static const NexNumAttr __val = {"val"};
+static const NexRefNumAttr __bco = {"bco"};
+static const NexRefNumAttr __pco = {"pco"};
+static const NexRefNumAttr __wid = {"wid"};
+static const NexRefNumAttr __picc = {"picc"};
+
 NexGauge::NexGauge(uint8_t pid, uint8_t cid, const char *name)
     :NexObject(pid, cid, name)
 {
@@ -22,137 +28,52 @@ NexGauge::NexGauge(uint8_t pid, uint8_t cid, const char *name)
 
 bool NexGauge::getValue(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".val";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__val, number);
 }
 
 bool NexGauge::setValue(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".val=";
-    cmd += buf;
-
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__val, number);
 }
 
 uint32_t NexGauge::Get_background_color_bco(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".bco";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__bco, number);
 }
 
 bool NexGauge::Set_background_color_bco(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".bco=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd="";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__bco, number);
 }
 
 uint32_t NexGauge::Get_font_color_pco(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".pco";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pco, number);
 }
 
 bool NexGauge::Set_font_color_pco(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pco=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__pco, number);
 }
 
 uint32_t NexGauge::Get_pointer_thickness_wid(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".wid";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__wid, number);
 }
 
 bool NexGauge::Set_pointer_thickness_wid(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".wid=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__wid, number);
 }
 
 uint32_t NexGauge::Get_background_cropi_picc(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".picc";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__picc, number);
 }
 
 bool NexGauge::Set_background_crop_picc(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".picc=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__picc, number);
 }
 
  
@@ -17,7 +17,7 @@
 bool NexGpio::pin_mode(uint32_t port,uint32_t mode,uint32_t control_id)
 {
     char buf;
-    String cmd;
+    NexCommand cmd;
     
     cmd += "cfgpio ";
     buf = port + '0';
@@ -36,7 +36,7 @@ bool NexGpio::pin_mode(uint32_t port,uint32_t mode,uint32_t control_id)
 
 bool NexGpio::digital_write(uint32_t port,uint32_t value)
 {
-    String cmd;
+    NexCommand cmd;
     char buf;
     
     cmd += "pio";
@@ -55,7 +55,7 @@ uint32_t NexGpio::digital_read(uint32_t port)
     uint32_t number;
     char buf;
     
-    String cmd = String("get ");
+    NexCommand cmd("get ");
     cmd += "pio";
     buf = port + '0';
     cmd += buf;
@@ -69,7 +69,7 @@ bool NexGpio::analog_write(uint32_t port,uint32_t value)
 {
     char buf[10] = {0};
     char c;
-    String cmd;
+    NexCommand cmd;
     
     utoa(value, buf, 10);
     cmd += "pwm";
@@ -78,7 +78,7 @@ bool NexGpio::analog_write(uint32_t port,uint32_t value)
     cmd += '=';
     cmd += buf;
     
-    Serial.print(cmd);
+    dbSerialPrint(cmd.c_str());
     sendCommand(cmd.c_str());
     return recvRetCommandFinished();   
 }
@@ -86,7 +86,7 @@ bool NexGpio::analog_write(uint32_t port,uint32_t value)
 bool NexGpio::set_pwmfreq(uint32_t value)
 {
     char buf[10] = {0};
-    String cmd;
+    NexCommand cmd;
     
     utoa(value, buf, 10);
     cmd += "pwmf";
@@ -99,7 +99,7 @@ bool NexGpio::set_pwmfreq(uint32_t value)
 
 uint32_t NexGpio::get_pwmfreq(uint32_t *number)
 {
-    String cmd = String("get pwmf");
+    NexCommand cmd("get pwmf");
     sendCommand(cmd.c_str());
     return recvRetNumber(number);
 }
\ No newline at end of file
@@ -31,6 +31,107 @@
 #define NEX_RET_INVALID_BAUD (0x11)
 #define NEX_RET_INVALID_VARIABLE (0x1A)
 #define NEX_RET_INVALID_OPERATION (0x1B)
+#define NEX_RET_SERIAL_OVERFLOW (0x24) /* sent by itself, not a reply */
+#define NEX_RET_LAST_RESULT (0x24)   /* codes up to here reply to a command */
+
+#define NEX_ASYNC_MASK (NEX_ASYNC_QUEUE - 1)
+#define NEX_FRAME_MAX (NEX_RX_STRING + 4) /* string, head and terminator */
+
+/*
+ * An asynchronous command waiting for its reply.
+ */
+struct NexPending
+{
+    uint32_t sent;
+    NexCompletion callback;
+    void *ptr;
+};
+
+static NexPending __pending[NEX_ASYNC_QUEUE];
+static uint8_t __pending_head = 0;
+static uint8_t __pending_tail = 0;
+static uint8_t __window = 0;        /* 0 in synchronous mode */
+static bool __resync = false;       /* dropping the late replies after a timeout */
+static uint32_t __resync_marker = 0; /* number the display echoes to end it */
+static uint32_t __resync_sent = 0;  /* time the marker was sent */
+static NexAsyncStats __async_stats;
+
+static uint8_t __frame[NEX_FRAME_MAX]; /* frame being received by receiveFrames */
+static uint16_t __frame_len = 0;
+static uint8_t __frame_size = 0;       /* 0 for a frame ending with 0xFF 0xFF 0xFF */
+static uint8_t __frame_ff = 0;
+static const NexHandlers *__handlers = NULL;
+static NexRxStats __rx_stats;
+
+static uint8_t __tx[NEX_TX_BUFFER];    /* commands not written yet */
+static uint16_t __tx_len = 0;
+static bool __batching = false;
+static NexTxStats __tx_stats;
+
+static const uint8_t __terminator[3] = {0xFF, 0xFF, 0xFF};
+
+/* the baudrates the display supports, from fast to slow */
+static const uint32_t __bauds[] = {921600, 512000, 256000, 250000, 230400, 115200,
+                                   57600, 38400, 31250, 19200, 9600, 4800, 2400};
+#define NEX_NR_OF_BAUDS (sizeof(__bauds) / sizeof(__bauds[0]))
+static uint32_t __find_first = 0;      /* rate of the link when nexFindBaudStep started */
+
+/*
+ * Writes the collected commands.
+ */
+static void flushTx(void)
+{
+    if (__tx_len == 0)
+    {
+        return;
+    }
+    nexSerial.write(__tx, __tx_len);
+    __tx_stats.writes++;
+    __tx_stats.bytes += __tx_len;
+    __tx_len = 0;
+}
+
+/*
+ * Adds a command with its terminator to the transmit buffer, which is
+ * written at once unless a batch is being collected.
+ */
+static void writeCommand(const char *cmd)
+{
+    size_t len = strlen(cmd);
+
+    if (__tx_len + len + sizeof(__terminator) > NEX_TX_BUFFER)
+    {
+        flushTx();
+    }
+    if (len + sizeof(__terminator) > NEX_TX_BUFFER)
+    {
+        // too long for the buffer
+        nexSerial.write((const uint8_t *)cmd, len);
+        nexSerial.write(__terminator, sizeof(__terminator));
+        __tx_stats.writes += 2;
+        __tx_stats.bytes += len + sizeof(__terminator);
+    }
+    else
+    {
+        memcpy(__tx + __tx_len, cmd, len);
+        memcpy(__tx + __tx_len + len, __terminator, sizeof(__terminator));
+        __tx_len += len + sizeof(__terminator);
+    }
+    __tx_stats.commands++;
+
+    if (!__batching)
+    {
+        flushTx();
+    }
+}
+
+/*
+ * Returns true for a command the display replies to with data.
+ */
+static bool isQuery(const char *cmd)
+{
+    return strncmp(cmd, "get ", 4) == 0 || strcmp(cmd, "sendme") == 0;
+}
 
 /*
  * Receive uint32_t data. 
@@ -52,6 +153,8 @@ bool recvRetNumber(uint32_t *number, uint32_t timeout)
         goto __return;
     }
 
+    flushTx();
+
     nexSerial.setTimeout(timeout);
     if (sizeof(temp) != nexSerial.readBytes((char *)temp, sizeof(temp)))
     {
@@ -95,7 +198,7 @@ uint16_t recvRetString(char *buffer, uint16_t len, uint32_t timeout)
     uint16_t ret = 0;
     bool str_start_flag = false;
     uint8_t cnt_0xff = 0;
-    String temp = String("");
+    uint16_t received = 0;
     uint8_t c = 0;
     long start;
 
@@ -104,6 +207,8 @@ uint16_t recvRetString(char *buffer, uint16_t len, uint32_t timeout)
         goto __return;
     }
 
+    flushTx();
+
     start = millis();
     while (millis() - start <= timeout)
     {
@@ -122,7 +227,12 @@ uint16_t recvRetString(char *buffer, uint16_t len, uint32_t timeout)
                 }
                 else
                 {
-                    temp += (char)c;
+                    // copied straight into the buffer, the rest is skipped
+                    if (received < len)
+                    {
+                        buffer[received] = (char)c;
+                    }
+                    received++;
                 }
             }
             else if (NEX_RET_STRING_HEAD == c)
@@ -137,16 +247,20 @@ uint16_t recvRetString(char *buffer, uint16_t len, uint32_t timeout)
         }
     }
 
-    ret = temp.length();
-    ret = ret > len ? len : ret;
-    strncpy(buffer, temp.c_str(), ret);
+    ret = received > len ? len : received;
+    if (ret < len)
+    {
+        buffer[ret] = '\0';
+    }
 
 __return:
 
     dbSerialPrint("recvRetString[");
-    dbSerialPrint(temp.length());
+    dbSerialPrint(received);
     dbSerialPrint(",");
-    dbSerialPrint(temp);
+#ifdef DEBUG_SERIAL_ENABLE
+    dbSerial.write((const uint8_t *)buffer, ret);
+#endif
     dbSerialPrintln("]");
 
     return ret;
@@ -159,16 +273,30 @@ __return:
  */
 void sendCommand(const char *cmd)
 {
+    // the display reloads all attributes of a page
+    if (strncmp(cmd, "page ", 5) == 0 || strcmp(cmd, "rest") == 0)
+    {
+        NexObject::invalidateAllShadows();
+    }
+
+    if (__window)
+    {
+        // the pending replies are still in the receive buffer
+        if (!isQuery(cmd))
+        {
+            nexAsyncSend(cmd);
+            return;
+        }
+        nexAsyncDrain();
+    }
+    
     while (nexSerial.available())
     {
         nexSerial.read();
     }
+    __frame_len = 0;
 
-    nexSerial.print(cmd);
-    //nexSerial.write(cmd);
-    nexSerial.write(0xFF);
-    nexSerial.write(0xFF);
-    nexSerial.write(0xFF);
+    writeCommand(cmd);
 }
 
 /*
@@ -185,6 +313,14 @@ bool recvRetCommandFinished(uint32_t timeout)
     bool ret = false;
     uint8_t temp[4] = {0};
 
+    if (__window)
+    {
+        // the reply is handled by nexAsyncPoll()
+        return true;
+    }
+
+    flushTx();
+
     nexSerial.setTimeout(timeout);
     if (sizeof(temp) != nexSerial.readBytes((char *)temp, sizeof(temp)))
     {
@@ -209,55 +345,579 @@ bool recvRetCommandFinished(uint32_t timeout)
     return ret;
 }
 
-bool nexInit(void)
+bool nexInit(uint32_t baud)
 {
     bool ret1 = false;
     bool ret2 = false;
+    uint32_t stored = nexLoadBaud();
 
     dbSerialBegin(115200);
-    // use the extended begin function
-    nexSerial.begin(115200, SERIAL_8N1, 16, 17, false);
+    // the pins are set when the transport is created
+    nexSerial.begin(stored ? stored : NEX_BAUD);
     delay(100);
-    sendCommand("");
-    sendCommand("bkcmd=1");
-    ret1 = recvRetCommandFinished(100);
+    ret1 = nexFindBaud() != 0;
+    if (ret1 && baud)
+    {
+        nexNegotiateBaud(baud);
+    }
     sendCommand("page 0");
     ret2 = recvRetCommandFinished(100);
     return ret1 && ret2;
 }
 
+/*
+ * Returns true if the display replies at baud.
+ */
+static bool probeBaud(uint32_t baud)
+{
+    if (nexSerial.baudRate() != baud)
+    {
+        nexSerial.begin(baud);
+    }
+    sendCommand("");
+    sendCommand("bkcmd=1");
+    return recvRetCommandFinished(100);
+}
+
+/*
+ * Sends baud= or bauds= with the rate.
+ */
+static void sendBaud(const char *cmd, uint32_t baud)
+{
+    char buf[11] = {0};
+    NexCommand command(cmd);
+
+    utoa(baud, buf, 10);
+    command += buf;
+    sendCommand(command.c_str());
+}
+
+/*
+ * Switches the link from one rate to the other. When the link doesn't work
+ * at the new rate, the display is told to go back, which it may not receive.
+ */
+static bool switchBaud(uint32_t baud, uint32_t from)
+{
+    uint32_t reported = 0;
+
+    sendBaud("baud=", baud);
+    if (!recvRetCommandFinished())
+    {
+        return false; // not accepted, still at the old rate
+    }
+    nexSerial.begin(baud);
+    sendCommand("get baud");
+    if (recvRetNumber(&reported) && reported == baud)
+    {
+        return true;
+    }
+    sendBaud("baud=", from);
+    nexSerial.begin(from);
+    return false;
+}
+
+/*
+ * Returns the rate nexFindBaudStep() tries at step, 0 after the last one.
+ * Step 0 is the rate the link was open at, 1 NEX_BAUD and then __bauds[].
+ */
+static uint32_t findBaud(uint8_t step)
+{
+    if (step == 0)
+    {
+        return __find_first;
+    }
+    if (step == 1)
+    {
+        return NEX_BAUD;
+    }
+    return step - 2U < NEX_NR_OF_BAUDS ? __bauds[step - 2] : 0;
+}
+
+uint8_t nexFindBaudStep(uint8_t step, uint32_t *found)
+{
+    uint32_t baud;
+    uint32_t stored;
+
+    *found = 0;
+    if (step == 0)
+    {
+        __find_first = nexSerial.baudRate() ? nexSerial.baudRate() : NEX_BAUD;
+    }
+    // a rate is only tried once
+    baud = findBaud(step);
+    while (baud && step > 0 && (baud == __find_first || (step > 1 && baud == NEX_BAUD)))
+    {
+        baud = findBaud(++step);
+    }
+    if (!baud)
+    {
+        nexSerial.begin(__find_first);
+        return 0;
+    }
+    if (!probeBaud(baud))
+    {
+        return step + 1;
+    }
+    stored = nexLoadBaud();
+    if (baud != (stored ? stored : NEX_BAUD))
+    {
+        nexSaveBaud(baud);
+    }
+    *found = baud;
+    return 0;
+}
+
+uint32_t nexFindBaud(void)
+{
+    uint32_t found = 0;
+    uint8_t step = 0;
+
+    do
+    {
+        step = nexFindBaudStep(step, &found);
+    } while (step);
+    return found;
+}
+
+uint32_t nexNegotiateBaud(uint32_t baud)
+{
+    uint32_t current = nexSerial.baudRate();
+
+    if (__window)
+    {
+        // the replies are needed right away
+        return current;
+    }
+    for (uint8_t i = 0; i < NEX_NR_OF_BAUDS && __bauds[i] > current; i++)
+    {
+        if (__bauds[i] > baud)
+        {
+            continue;
+        }
+        if (switchBaud(__bauds[i], current))
+        {
+            // also the rate the display starts with from now on
+            sendBaud("bauds=", __bauds[i]);
+            recvRetCommandFinished();
+            nexSaveBaud(__bauds[i]);
+            dbSerialPrint("nexNegotiateBaud: ");
+            dbSerialPrintln(__bauds[i]);
+            return __bauds[i];
+        }
+        if (!probeBaud(current))
+        {
+            // the display didn't get the way back
+            return nexFindBaud();
+        }
+    }
+    return current;
+}
+
+static void receiveFrames(NexTouch *nex_listen_list[]);
+
 void nexLoop(NexTouch *nex_listen_list[])
 {
-    static uint8_t __buffer[10];
+    if (__window)
+    {
+        nexAsyncPoll(nex_listen_list);
+        return;
+    }
+    receiveFrames(nex_listen_list);
+}
 
-    uint16_t i;
-    uint8_t c;
+void nexSetHandlers(const NexHandlers *handlers)
+{
+    __handlers = handlers;
+}
 
-    while (nexSerial.available() > 0)
+const NexRxStats &nexRxStats(void)
+{
+    return __rx_stats;
+}
+
+/*
+ * Completes the oldest outstanding command.
+ */
+static void completePending(uint8_t code)
+{
+    NexPending &p = __pending[__pending_tail & NEX_ASYNC_MASK];
+    bool ok = (code == NEX_RET_CMD_FINISHED);
+
+    __pending_tail++;
+    if (ok)
+    {
+        __async_stats.acked++;
+    }
+    else if (code == NEX_RET_ASYNC_TIMEOUT)
+    {
+        __async_stats.timeouts++;
+        dbSerialPrintln("nexAsync timeout");
+    }
+    else
+    {
+        __async_stats.failed++;
+        printError(&code);
+    }
+    if (!ok)
+    {
+        // a cache may hold a value the display didn't accept
+        NexObject::invalidateAllShadows();
+    }
+    if (p.callback)
+    {
+        p.callback(ok, code, p.ptr);
+    }
+}
+
+/*
+ * Returns the size of a reply starting with head, 0 if it ends with
+ * 0xFF 0xFF 0xFF only.
+ */
+static uint8_t frameSize(uint8_t head)
+{
+    switch (head)
     {
-        delay(10);
-        c = nexSerial.read();
+    case NEX_RET_INVALID_CMD: /* also the 0x00 0x00 0x00 of the startup */
+    case NEX_RET_STRING_HEAD:
+        return 0;
+    case NEX_RET_EVENT_TOUCH_HEAD:
+        return 7;
+    case NEX_RET_CURRENT_PAGE_ID_HEAD:
+        return 5;
+    case NEX_RET_EVENT_POSITION_HEAD:
+    case NEX_RET_EVENT_SLEEP_POSITION_HEAD:
+        return 9;
+    case NEX_RET_NUMBER_HEAD:
+        return 8;
+    default:
+        return 4;
+    }
+}
 
-        if (NEX_RET_EVENT_TOUCH_HEAD == c)
+/*
+ * Returns true if a frame has a receiver and counts it.
+ */
+static bool dispatch(bool receiver)
+{
+    if (!receiver)
+    {
+        return false;
+    }
+    __rx_stats.dispatched++;
+    return true;
+}
+
+/*
+ * Handles a result code, the reply to the oldest asynchronous command or
+ * an error nobody waits for.
+ */
+static void handleResult(uint8_t code)
+{
+    if (__resync && code != NEX_RET_SERIAL_OVERFLOW && code <= NEX_RET_LAST_RESULT)
+    {
+        // the reply to a command that already timed out
+        __async_stats.dropped++;
+        return;
+    }
+    if (code != NEX_RET_SERIAL_OVERFLOW && code <= NEX_RET_LAST_RESULT &&
+        __pending_head != __pending_tail)
+    {
+        completePending(code);
+        return;
+    }
+    if (__window)
+    {
+        __async_stats.unexpected++;
+    }
+    if (code != NEX_RET_CMD_FINISHED && dispatch(__handlers && __handlers->error))
+    {
+        __handlers->error(code);
+    }
+}
+
+/*
+ * Returns the number of a received 0x71 frame.
+ */
+static uint32_t frameNumber(void)
+{
+    return ((uint32_t)__frame[4] << 24) | ((uint32_t)__frame[3] << 16) |
+           ((uint32_t)__frame[2] << 8) | __frame[1];
+}
+
+/*
+ * Handles a complete frame received by receiveFrames.
+ */
+static void handleFrame(NexTouch *nex_listen_list[])
+{
+    uint8_t code = __frame[0];
+    uint16_t len;
+
+    __rx_stats.frames++;
+    switch (code)
+    {
+    case NEX_RET_EVENT_TOUCH_HEAD:
+        if (dispatch(nex_listen_list != NULL))
+        {
+            NexTouch::iterate(nex_listen_list, __frame[1], __frame[2], (int32_t)__frame[3]);
+        }
+        break;
+    case NEX_RET_CURRENT_PAGE_ID_HEAD:
+        // the display reloads all attributes of a page
+        NexObject::invalidateAllShadows();
+        if (dispatch(__handlers && __handlers->page))
+        {
+            __handlers->page(__frame[1]);
+        }
+        break;
+    case NEX_RET_EVENT_POSITION_HEAD:
+    case NEX_RET_EVENT_SLEEP_POSITION_HEAD:
+        if (dispatch(__handlers && __handlers->position))
+        {
+            __handlers->position(((uint16_t)__frame[1] << 8) | __frame[2],
+                                 ((uint16_t)__frame[3] << 8) | __frame[4],
+                                 __frame[5] != 0, code == NEX_RET_EVENT_SLEEP_POSITION_HEAD);
+        }
+        break;
+    case NEX_RET_NUMBER_HEAD:
+        if (__resync)
+        {
+            // all replies sent before the marker have arrived, an older
+            // marker or number belongs to the dropped ones
+            __resync = frameNumber() != __resync_marker;
+            __async_stats.dropped += __resync ? 1 : 0;
+            break;
+        }
+        if (dispatch(__handlers && __handlers->number))
+        {
+            __handlers->number(frameNumber());
+        }
+        break;
+    case NEX_RET_STRING_HEAD:
+        // without the head and terminator, the rest of a long one is lost
+        len = __frame_len - 4;
+        if (len > NEX_RX_STRING)
+        {
+            len = NEX_RX_STRING;
+        }
+        __frame[1 + len] = '\0';
+        if (dispatch(__handlers && __handlers->string))
+        {
+            __handlers->string((const char *)&__frame[1], len);
+        }
+        break;
+    case NEX_EVENT_SLEEP:
+    case NEX_EVENT_WAKE:
+    case NEX_EVENT_READY:
+    case NEX_EVENT_UPGRADE:
+    case NEX_EVENT_DATA_DONE:
+    case NEX_EVENT_DATA_READY:
+        if (dispatch(__handlers && __handlers->event))
         {
-            if (nexSerial.available() >= 6)
+            __handlers->event(code);
+        }
+        break;
+    case NEX_RET_INVALID_CMD:
+        if (__frame_len == 6)
+        {
+            if (dispatch(__handlers && __handlers->event))
             {
-                __buffer[0] = c;
-                for (i = 1; i < 7; i++)
-                {
-                    __buffer[i] = nexSerial.read();
-                }
-                __buffer[i] = 0x00;
+                __handlers->event(NEX_EVENT_STARTUP);
+            }
+            break;
+        }
+        handleResult(code);
+        break;
+    default:
+        handleResult(code);
+        break;
+    }
+}
 
-                if (0xFF == __buffer[4] && 0xFF == __buffer[5] && 0xFF == __buffer[6])
-                {
-                    NexTouch::iterate(nex_listen_list, __buffer[1], __buffer[2], (int32_t)__buffer[3]);
-                }
+/*
+ * Assembles the frames from the received bytes and handles them. A frame
+ * is completed by a later call when its bytes haven't all arrived yet.
+ */
+static void receiveFrames(NexTouch *nex_listen_list[])
+{
+    while (nexSerial.available() > 0)
+    {
+        uint8_t c = nexSerial.read();
+
+        if (__frame_len == 0)
+        {
+            __frame_size = frameSize(c);
+            __frame_ff = 0;
+        }
+        if (__frame_len < NEX_FRAME_MAX)
+        {
+            __frame[__frame_len] = c;
+        }
+        __frame_len++;
+        __frame_ff = (c == 0xFF) ? __frame_ff + 1 : 0;
+
+        if (__frame_size == 0 ? __frame_ff >= 3 : __frame_len >= __frame_size)
+        {
+            if (__frame_ff >= 3)
+            {
+                handleFrame(nex_listen_list);
             }
+            else
+            {
+                __rx_stats.invalid++; // out of sync, skip the frame
+            }
+            __frame_len = 0;
+        }
+    }
+}
+
+bool nexAsyncBegin(uint8_t window)
+{
+    nexAsyncEnd();
+    sendCommand("bkcmd=3");
+    if (!recvRetCommandFinished())
+    {
+        return false;
+    }
+    __window = window > NEX_ASYNC_QUEUE ? NEX_ASYNC_QUEUE : window;
+    __resync = false;
+    __frame_len = 0;
+    return true;
+}
+
+void nexAsyncEnd(void)
+{
+    if (!__window)
+    {
+        return;
+    }
+    nexAsyncDrain();
+    __window = 0;
+    sendCommand("bkcmd=1");
+    recvRetCommandFinished();
+}
+
+bool nexAsyncSend(const char *cmd, NexCompletion callback, void *ptr)
+{
+    if (!__window)
+    {
+        return false;
+    }
+    if (nexAsyncPending() >= __window)
+    {
+        __async_stats.stalls++;
+        // the commands in flight may still be in the batch
+        flushTx();
+        // the oldest command times out if its reply doesn't arrive
+        do
+        {
+            yield();
+            nexAsyncPoll();
+        } while (nexAsyncPending() >= __window);
+    }
+
+    NexPending &p = __pending[__pending_head & NEX_ASYNC_MASK];
+    p.sent = millis();
+    p.callback = callback;
+    p.ptr = ptr;
+    __pending_head++;
+
+    writeCommand(cmd);
+    __async_stats.sent++;
+    if (nexAsyncPending() > __async_stats.maxPending)
+    {
+        __async_stats.maxPending = nexAsyncPending();
+    }
+    return true;
+}
+
+/*
+ * Asks the display to echo a new marker, the result codes received before
+ * it belong to commands which already timed out.
+ */
+static void sendResyncMarker(void)
+{
+    char buf[11] = {0};
+    NexCommand command("get ");
+
+    utoa(++__resync_marker, buf, 10);
+    command += buf;
+    writeCommand(command.c_str());
+    flushTx();
+    __resync = true;
+    __resync_sent = millis();
+    __async_stats.resyncs++;
+}
+
+void nexAsyncPoll(NexTouch *nex_listen_list[])
+{
+    receiveFrames(nex_listen_list);
+
+    if (__pending_head != __pending_tail &&
+        millis() - __pending[__pending_tail & NEX_ASYNC_MASK].sent > NEX_ASYNC_TIMEOUT)
+    {
+        // the replies can't be matched anymore, so all commands in flight
+        // fail and their replies are dropped up to the marker
+        while (__pending_head != __pending_tail)
+        {
+            completePending(NEX_RET_ASYNC_TIMEOUT);
         }
+        sendResyncMarker();
+    }
+    else if (__resync && __pending_head == __pending_tail &&
+             millis() - __resync_sent > NEX_ASYNC_TIMEOUT)
+    {
+        // the marker was lost, e.g. by a restart of the display
+        sendResyncMarker();
     }
 }
 
+void nexAsyncDrain(void)
+{
+    flushTx();
+    while (__pending_head != __pending_tail)
+    {
+        yield();
+        nexAsyncPoll();
+    }
+    // a display that doesn't echo the marker is not waited for
+    uint32_t start = millis();
+    while (__resync && millis() - start <= NEX_ASYNC_TIMEOUT)
+    {
+        yield();
+        nexAsyncPoll();
+    }
+}
+
+void nexBatchBegin(void)
+{
+    __batching = true;
+}
+
+void nexBatchEnd(void)
+{
+    if (__tx_len > 0)
+    {
+        __tx_stats.batches++;
+    }
+    flushTx();
+    __batching = false;
+}
+
+const NexTxStats &nexTxStats(void)
+{
+    return __tx_stats;
+}
+
+uint8_t nexAsyncPending(void)
+{
+    return (uint8_t)(__pending_head - __pending_tail);
+}
+
+const NexAsyncStats &nexAsyncStats(void)
+{
+    return __async_stats;
+}
+
 /* 
 *   Prints a discriptive error message
 */
@@ -329,7 +989,8 @@ void printError(uint8_t *errNr)
         }
         break;
     default:
-        dbSerial.println("Error : Unknown failure: " + String(errNr[0], HEX));
+        dbSerial.print("Error : Unknown failure: ");
+        dbSerial.println(errNr[0], HEX);
 
         break;
     }
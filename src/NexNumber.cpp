@@ -14,6 +14,16 @@
  */
 #include "NexNumber.h"
 
+static const NexNumAttr __val = {"val"};
+static const NexRefNumAttr __bco = {"bco"};
+static const NexRefNumAttr __pco = {"pco"};
+static const NexRefNumAttr __xcen = {"xcen"};
+static const NexRefNumAttr __ycen = {"ycen"};
+static const NexRefNumAttr __font = {"font"};
+static const NexRefNumAttr __lenth = {"lenth"};
+static const NexRefNumAttr __picc = {"picc"};
+static const NexRefNumAttr __pic = {"pic"};
+
 NexNumber::NexNumber(uint8_t pid, uint8_t cid, const char *name)
     :NexTouch(pid, cid, name)
 {
@@ -21,246 +31,90 @@ NexNumber::NexNumber(uint8_t pid, uint8_t cid, const char *name)
 
 bool NexNumber::getValue(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".val";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__val, number);
 }
 
 bool NexNumber::setValue(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".val=";
-    cmd += buf;
-
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__val, number);
 }
 
 uint32_t NexNumber::Get_background_color_bco(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".bco";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__bco, number);
 }
 
 bool NexNumber::Set_background_color_bco(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".bco=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd="";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__bco, number);
 }
 
 uint32_t NexNumber::Get_font_color_pco(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".pco";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pco, number);
 }
 
 bool NexNumber::Set_font_color_pco(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pco=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__pco, number);
 }
 
 uint32_t NexNumber::Get_place_xcen(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".xcen";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__xcen, number);
 }
 
 bool NexNumber::Set_place_xcen(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".xcen=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__xcen, number);
 }
 
 uint32_t NexNumber::Get_place_ycen(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".ycen";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__ycen, number);
 }
 
 bool NexNumber::Set_place_ycen(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".ycen=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__ycen, number);
 }
 
 uint32_t NexNumber::getFont(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".font";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__font, number);
 }
 
 bool NexNumber::setFont(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".font=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__font, number);
 }
 
 uint32_t NexNumber::Get_number_lenth(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".lenth";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__lenth, number);
 }
 
 bool NexNumber::Set_number_lenth(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".lenth=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__lenth, number);
 }
 
 uint32_t NexNumber::Get_background_crop_picc(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".picc";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__picc, number);
 }
 
 bool NexNumber::Set_background_crop_picc(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".picc=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__picc, number);
 }
 
 uint32_t NexNumber::Get_background_image_pic(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".pic";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pic, number);
 }
 
 bool NexNumber::Set_background_image_pic(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pic=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__pic, number);
 }
\ No newline at end of file
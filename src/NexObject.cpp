@@ -13,12 +13,165 @@
  * the License, or (at your option) any later version.
  */
 #include "NexObject.h"
+#include "NexHardware.h"
+
+uint32_t NexObject::__shadow_generation = 1;
+NexShadowStats NexObject::__shadow_stats;
+bool NexObject::__redraw_active = false;
+uint8_t NexObject::__redraw_count = 0;
+NexObject *NexObject::__redraw_dirty[NEX_REDRAW_MAX];
+NexRedrawStats NexObject::__redraw_stats;
+
+/*
+ * FNV-1a hash of a string, remembered instead of the string itself.
+ */
+static uint32_t hashText(const char *str)
+{
+    uint32_t hash = 2166136261UL;
+    while (*str)
+    {
+        hash = (hash ^ (uint8_t)*str++) * 16777619UL;
+    }
+    return hash;
+}
 
 NexObject::NexObject(uint8_t pid, uint8_t cid, const char *name)
 {
     this->__pid = pid;
     this->__cid = cid;
     this->__name = name;
+    this->__shadow = NULL;
+    this->__shadow_count = 0;
+}
+
+void NexObject::attachShadow(NexShadowEntry *entries, uint8_t count)
+{
+    __shadow = entries;
+    __shadow_count = count;
+    invalidateShadow();
+}
+
+void NexObject::invalidateShadow(void)
+{
+    for (uint8_t i = 0; i < __shadow_count; i++)
+    {
+        __shadow[i].attr = NULL;
+    }
+}
+
+void NexObject::invalidateAllShadows(void)
+{
+    __shadow_generation++;
+    __shadow_stats.invalidations++;
+}
+
+const NexShadowStats &NexObject::shadowStats(void)
+{
+    return __shadow_stats;
+}
+
+NexShadowEntry *NexObject::findShadow(const char *attr)
+{
+    for (uint8_t i = 0; i < __shadow_count; i++)
+    {
+        NexShadowEntry &e = __shadow[i];
+        if (e.attr && e.generation == __shadow_generation &&
+            (e.attr == attr || strcmp(e.attr, attr) == 0))
+        {
+            return &e;
+        }
+    }
+    return NULL;
+}
+
+void NexObject::storeShadow(const char *attr, uint32_t value)
+{
+    NexShadowEntry *e = findShadow(attr);
+
+    if (!__shadow_count)
+    {
+        return;
+    }
+    // reuse an unused or outdated entry, otherwise the last one
+    for (uint8_t i = 0; !e && i < __shadow_count; i++)
+    {
+        if (!__shadow[i].attr || __shadow[i].generation != __shadow_generation)
+        {
+            e = &__shadow[i];
+        }
+    }
+    if (!e)
+    {
+        e = &__shadow[__shadow_count - 1];
+    }
+    e->attr = attr;
+    e->value = value;
+    e->generation = __shadow_generation;
+}
+
+void NexObject::beginRedraw(void)
+{
+    __redraw_active = true;
+    __redraw_count = 0;
+}
+
+bool NexObject::commitRedraw(void)
+{
+    bool ret = true;
+
+    __redraw_active = false;
+    __redraw_stats.transactions++;
+    for (uint8_t i = 0; i < __redraw_count; i++)
+    {
+        NexCommand cmd("ref ");
+        cmd += __redraw_dirty[i]->__name;
+        sendCommand(cmd.c_str());
+        __redraw_stats.refs++;
+        /*
+         * sendCommand empties the receive buffer in synchronous mode, so
+         * every reply is taken before the next ref. In asynchronous mode
+         * this returns at once and the refs are pipelined.
+         */
+        if (!recvRetCommandFinished())
+        {
+            ret = false;
+        }
+    }
+    __redraw_count = 0;
+    return ret;
+}
+
+const NexRedrawStats &NexObject::redrawStats(void)
+{
+    return __redraw_stats;
+}
+
+/*
+ * Mark the component dirty instead of sending its ref, if a redraw
+ * transaction is running and has room for it.
+ */
+bool NexObject::deferRef(void)
+{
+    if (!__redraw_active)
+    {
+        return false;
+    }
+    for (uint8_t i = 0; i < __redraw_count; i++)
+    {
+        if (__redraw_dirty[i] == this)
+        {
+            __redraw_stats.deferred++;
+            return true;
+        }
+    }
+    if (__redraw_count >= NEX_REDRAW_MAX)
+    {
+        __redraw_stats.overflows++;
+        return false;
+    }
+    __redraw_dirty[__redraw_count++] = this;
+    __redraw_stats.deferred++;
+    return true;
 }
 
 uint8_t NexObject::getObjPid(void)
@@ -36,10 +189,118 @@ const char* NexObject::getObjName(void)
     return __name;
 }
 
+bool NexObject::getNumberAttr(const char *attr, uint32_t *number)
+{
+    NexShadowEntry *e = findShadow(attr);
+
+    if (e && number)
+    {
+        __shadow_stats.hits++;
+        *number = e->value;
+        return true;
+    }
+
+    NexCommand cmd("get ");
+    cmd += __name;
+    cmd += '.';
+    cmd += attr;
+    sendCommand(cmd.c_str());
+    if (!recvRetNumber(number))
+    {
+        return false;
+    }
+    storeShadow(attr, *number);
+    return true;
+}
+
+bool NexObject::setNumberAttr(const char *attr, uint32_t number, bool ref)
+{
+    char buf[10] = {0};
+    NexCommand cmd;
+    NexShadowEntry *e = findShadow(attr);
+
+    if (e && e->value == number)
+    {
+        __shadow_stats.skippedWrites++;
+        return true;
+    }
+
+    utoa(number, buf, 10);
+    cmd += __name;
+    cmd += '.';
+    cmd += attr;
+    cmd += '=';
+    cmd += buf;
+    sendCommand(cmd.c_str());
+    /*
+     * The reply is taken before the ref is sent, which would empty the
+     * receive buffer in synchronous mode. The ref has its own reply, which
+     * must not be taken for the reply of the next command.
+     */
+    bool ret = recvRetCommandFinished();
+    if (ref && !deferRef())
+    {
+        cmd = "ref ";
+        cmd += __name;
+        sendCommand(cmd.c_str());
+        if (!recvRetCommandFinished())
+        {
+            ret = false;
+        }
+    }
+    if (!ret)
+    {
+        return false;
+    }
+    storeShadow(attr, number);
+    return true;
+}
+
+uint16_t NexObject::getTextAttr(const char *attr, char *buffer, uint16_t len)
+{
+    NexCommand cmd("get ");
+    cmd += __name;
+    cmd += '.';
+    cmd += attr;
+    sendCommand(cmd.c_str());
+    uint16_t ret = recvRetString(buffer, len);
+    if (ret > 0 && ret < len)
+    {
+        storeShadow(attr, hashText(buffer));
+    }
+    return ret;
+}
+
+bool NexObject::setTextAttr(const char *attr, const char *buffer)
+{
+    NexCommand cmd;
+    NexShadowEntry *e = findShadow(attr);
+    uint32_t hash = __shadow_count ? hashText(buffer) : 0;
+
+    if (e && e->value == hash)
+    {
+        __shadow_stats.skippedWrites++;
+        return true;
+    }
+    cmd += __name;
+    cmd += '.';
+    cmd += attr;
+    cmd += "=\"";
+    cmd += buffer;
+    cmd += "\"";
+    sendCommand(cmd.c_str());
+    if (!recvRetCommandFinished())
+    {
+        return false;
+    }
+    storeShadow(attr, hash);
+    return true;
+}
+
 void NexObject::printObjInfo(void)
 {
     dbSerialPrint("[");
-    dbSerialPrint((uint32_t)this);
+    dbSerialPrint((uintptr_t)this);
     dbSerialPrint(":");
     dbSerialPrint(__pid);
     dbSerialPrint(",");
@@ -30,7 +30,7 @@ bool NexPage::show(void)
         return false;
     }
     
-    String cmd = String("page ");
+    NexCommand cmd("page ");
     cmd += name;
     sendCommand(cmd.c_str());
     return recvRetCommandFinished();
@@ -17,7 +17,7 @@
 bool NexRtc::write_rtc_time(char *time)
 {
     char year[5],mon[3],day[3],hour[3],min[3],sec[3];
-    String cmd = String("rtc");
+    NexCommand cmd("rtc");
     int i;
     
     if(strlen(time) >= 19)
@@ -74,7 +74,7 @@ bool NexRtc::write_rtc_time(char *time)
 bool NexRtc::write_rtc_time(uint32_t *time)
 {
     char year[5],mon[3],day[3],hour[3],min[3],sec[3];
-    String cmd = String("rtc");
+    NexCommand cmd("rtc");
     int i;
     
      utoa(time[0],year,10);
@@ -124,7 +124,7 @@ bool NexRtc::write_rtc_time(uint32_t *time)
 
 bool NexRtc::write_rtc_time(char *time_type,uint32_t number)
 {
-    String cmd = String("rtc");
+    NexCommand cmd("rtc");
     char buf[10] = {0};
     
     utoa(number, buf, 10);
@@ -167,7 +167,7 @@ uint32_t NexRtc::read_rtc_time(char *time,uint32_t len)
 {
     char time_buf[22] = {"0000/00/00 00:00:00 0"};
     uint32_t year,mon,day,hour,min,sec,week;
-    String cmd;
+    NexCommand cmd;
     
     cmd = "get rtc0";
     sendCommand(cmd.c_str());
@@ -240,7 +240,7 @@ uint32_t NexRtc::read_rtc_time(char *time,uint32_t len)
 uint32_t NexRtc::read_rtc_time(uint32_t *time,uint32_t len)
 {
     uint32_t time_buf[7] = {0};
-    String cmd;
+    NexCommand cmd;
     
     cmd = "get rtc0";
     sendCommand(cmd.c_str());
@@ -287,7 +287,7 @@ uint32_t NexRtc::read_rtc_time(uint32_t *time,uint32_t len)
 
 uint32_t NexRtc::read_rtc_time(char *time_type,uint32_t *number)
 {
-    String cmd = String("get rtc");
+    NexCommand cmd("get rtc");
     char buf[10] = {0};
     
     if(strstr(time_type,"year"))
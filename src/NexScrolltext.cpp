@@ -14,6 +14,19 @@
  */
 #include "NexScrolltext.h"
 
+static const NexTextAttr __txt = {"txt"};
+static const NexRefNumAttr __bco = {"bco"};
+static const NexRefNumAttr __pco = {"pco"};
+static const NexRefNumAttr __xcen = {"xcen"};
+static const NexRefNumAttr __ycen = {"ycen"};
+static const NexRefNumAttr __font = {"font"};
+static const NexRefNumAttr __picc = {"picc"};
+static const NexRefNumAttr __pic = {"pic"};
+static const NexRefNumAttr __dir = {"dir"};
+static const NexRefNumAttr __dis = {"dis"};
+static const NexRefNumAttr __tim = {"tim"};
+static const NexNumAttr __en = {"en"};
+
 NexScrolltext::NexScrolltext(uint8_t pid, uint8_t cid, const char *name)
     :NexTouch(pid, cid, name)
 {
@@ -21,331 +34,129 @@ NexScrolltext::NexScrolltext(uint8_t pid, uint8_t cid, const char *name)
 
 uint16_t NexScrolltext::getText(char *buffer, uint16_t len)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".txt";
-    sendCommand(cmd.c_str());
-    return recvRetString(buffer,len);
+    return getAttr(__txt, buffer, len);
 }
 
 bool NexScrolltext::setText(const char *buffer)
 {
-    String cmd;
-    cmd += getObjName();
-    cmd += ".txt=\"";
-    cmd += buffer;
-    cmd += "\"";
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();    
+    return setAttr(__txt, buffer);
 }
 
 uint32_t NexScrolltext::Get_background_color_bco(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".bco";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__bco, number);
 }
 
 bool NexScrolltext::Set_background_color_bco(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".bco=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd="";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__bco, number);
 }
 
 uint32_t NexScrolltext::Get_font_color_pco(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".pco";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pco, number);
 }
 
 bool NexScrolltext::Set_font_color_pco(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pco=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__pco, number);
 }
 
 uint32_t NexScrolltext::Get_place_xcen(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".xcen";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__xcen, number);
 }
 
 bool NexScrolltext::Set_place_xcen(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".xcen=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__xcen, number);
 }
 
 uint32_t NexScrolltext::Get_place_ycen(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".ycen";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__ycen, number);
 }
 
 bool NexScrolltext::Set_place_ycen(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".ycen=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__ycen, number);
 }
 
 uint32_t NexScrolltext::getFont(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".font";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__font, number);
 }
 
 bool NexScrolltext::setFont(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".font=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__font, number);
 }
 
 uint32_t NexScrolltext::Get_background_crop_picc(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".picc";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__picc, number);
 }
 
 bool NexScrolltext::Set_background_crop_picc(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".picc=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__picc, number);
 }
 
 uint32_t NexScrolltext::Get_background_image_pic(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".pic";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pic, number);
 }
 
 bool NexScrolltext::Set_background_image_pic(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pic=";
-    cmd += buf;
-	sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__pic, number);
 }
 
 uint32_t NexScrolltext::Get_scroll_dir(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".dir";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__dir, number);
 }
 
 bool NexScrolltext::Set_scroll_dir(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".dir=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__dir, number);
 }
 
 uint32_t NexScrolltext::Get_scroll_distance(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".dis";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__dis, number);
 }
 
 bool NexScrolltext::Set_scroll_distance(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
     if (number < 2)
     {
         number = 2;
     }
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".dis=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__dis, number);
 }
 
 uint32_t NexScrolltext::Get_cycle_tim(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".tim";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__tim, number);
 }
 
 bool NexScrolltext::Set_cycle_tim(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
     if (number < 8)
     {
         number = 8;
     }
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".tim=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__tim, number);
 }
 
 
 bool NexScrolltext::enable(void)
 {
-    char buf[10] = {0};
-    String cmd;
-    utoa(1, buf, 10);
-    cmd += getObjName();
-    cmd += ".en=";
-    cmd += buf;
-
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__en, 1);
 }
 
 bool NexScrolltext::disable(void)
 {
-    char buf[10] = {0};
-    String cmd;
-    utoa(0, buf, 10);
-    cmd += getObjName();
-    cmd += ".en=";
-    cmd += buf;
-
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__en, 0);
 }
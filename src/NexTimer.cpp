@@ -15,6 +15,10 @@
 
 #include "NexTimer.h"
 
+static const NexNumAttr __tim = {"tim"};
+static const NexRefNumAttr __timRef = {"tim"};
+static const NexNumAttr __en = {"en"};
+
 NexTimer::NexTimer(uint8_t pid, uint8_t cid, const char *name)
     :NexTouch(pid, cid, name)
 {
@@ -32,84 +36,40 @@ void NexTimer::detachTimer(void)
 
 bool NexTimer::getCycle(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".tim";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__tim, number);
 }
 
 bool NexTimer::setCycle(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
     if (number < 50)
     {
         number = 50;
     }
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".tim=";
-    cmd += buf;
-
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__tim, number);
 }
 
 
 bool NexTimer::enable(void)
 {
-    char buf[10] = {0};
-    String cmd;
-    utoa(1, buf, 10);
-    cmd += getObjName();
-    cmd += ".en=";
-    cmd += buf;
-
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__en, 1);
 }
 
 bool NexTimer::disable(void)
 {
-    char buf[10] = {0};
-    String cmd;
-    utoa(0, buf, 10);
-    cmd += getObjName();
-    cmd += ".en=";
-    cmd += buf;
-
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__en, 0);
 }
 
 uint32_t NexTimer::Get_cycle_tim(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".tim";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__tim, number);
 }
 
 bool NexTimer::Set_cycle_tim(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
     if (number < 8)
     {
         number = 8;
     }
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".tim=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd = "";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__timRef, number);
 }
 
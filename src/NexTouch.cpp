@@ -14,6 +14,19 @@
  */
 #include "NexTouch.h"
 
+#define NEX_TOUCH_INDEX_MASK (NEX_TOUCH_INDEX - 1)
+
+NexTouch *NexTouch::__index[NEX_TOUCH_INDEX];
+NexTouch **NexTouch::__index_list = NULL;
+bool NexTouch::__index_used = false;
+
+/*
+ * First slot of the index to probe for a component.
+ */
+static uint8_t indexSlot(uint8_t pid, uint8_t cid)
+{
+    return (uint8_t)((pid * 37U + cid) & NEX_TOUCH_INDEX_MASK);
+}
 
 NexTouch::NexTouch(uint8_t pid, uint8_t cid, const char *name)
     :NexObject(pid, cid, name)
@@ -64,32 +77,105 @@ void NexTouch::pop(void)
     }
 }
 
-void NexTouch::iterate(NexTouch **list, uint8_t pid, uint8_t cid, int32_t event)
+bool NexTouch::buildIndex(NexTouch **list)
 {
     NexTouch *e = NULL;
     uint16_t i = 0;
 
+    memset(__index, 0, sizeof(__index));
+    __index_list = list;
+    __index_used = false;
     if (NULL == list)
     {
-        return;
+        return false;
     }
-    
-    for(i = 0; (e = list[i]) != NULL; i++)
+
+    while (list[i] != NULL)
     {
-        if (e->getObjPid() == pid && e->getObjCid() == cid)
+        i++;
+    }
+    if (i > NEX_TOUCH_INDEX * 3 / 4)
+    {
+        return false;
+    }
+
+    for (i = 0; (e = list[i]) != NULL; i++)
+    {
+        uint8_t slot = indexSlot(e->getObjPid(), e->getObjCid());
+        while (__index[slot] != NULL)
         {
-            e->printObjInfo();
-            if (NEX_EVENT_PUSH == event)
+            if (__index[slot]->getObjPid() == e->getObjPid() &&
+                __index[slot]->getObjCid() == e->getObjCid())
             {
-                e->push();
+                break; // like the walk, the first one in the list wins
             }
-            else if (NEX_EVENT_POP == event)
+            slot = (slot + 1) & NEX_TOUCH_INDEX_MASK;
+        }
+        if (__index[slot] == NULL)
+        {
+            __index[slot] = e;
+        }
+    }
+    __index_used = true;
+    return true;
+}
+
+NexTouch *NexTouch::find(NexTouch **list, uint8_t pid, uint8_t cid)
+{
+    NexTouch *e = NULL;
+    uint16_t i = 0;
+
+    if (list != __index_list)
+    {
+        buildIndex(list);
+    }
+
+    if (__index_used)
+    {
+        for (i = indexSlot(pid, cid); (e = __index[i]) != NULL; i = (i + 1) & NEX_TOUCH_INDEX_MASK)
+        {
+            if (e->getObjPid() == pid && e->getObjCid() == cid)
             {
-                e->pop();
+                return e;
             }
-            
-            break;
         }
+        return NULL;
+    }
+
+    for (i = 0; (e = list[i]) != NULL; i++)
+    {
+        if (e->getObjPid() == pid && e->getObjCid() == cid)
+        {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+void NexTouch::iterate(NexTouch **list, uint8_t pid, uint8_t cid, int32_t event)
+{
+    NexTouch *e = NULL;
+
+    if (NULL == list)
+    {
+        return;
+    }
+    
+    e = find(list, pid, cid);
+    if (NULL == e)
+    {
+        return;
+    }
+#ifdef DEBUG_TOUCH_ENABLE
+    e->printObjInfo();
+#endif
+    if (NEX_EVENT_PUSH == event)
+    {
+        e->push();
+    }
+    else if (NEX_EVENT_POP == event)
+    {
+        e->pop();
     }
 }
 
@@ -14,6 +14,9 @@
  */
 #include "NexVariable.h"
 
+static const NexNumAttr __val = {"val"};
+static const NexTextAttr __txt = {"txt"};
+
 NexVariable::NexVariable(uint8_t pid, uint8_t cid, const char *name)
     :NexTouch(pid, cid, name)
 {
@@ -21,44 +24,20 @@ NexVariable::NexVariable(uint8_t pid, uint8_t cid, const char *name)
 
 uint32_t NexVariable::getValue(uint32_t *number)
 {
-    String cmd = String("get ");
-    cmd += getObjName();
-    cmd += ".val";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__val, number);
 }
 
 bool NexVariable::setValue(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".val=";
-    cmd += buf;
-
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__val, number);
 }
 
 uint32_t NexVariable::getText(char *buffer, uint32_t len)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".txt";
-    sendCommand(cmd.c_str());
-    return recvRetString(buffer,len);
+    return getAttr(__txt, buffer, len);
 }
 
 bool NexVariable::setText(const char *buffer)
 {
-    String cmd;
-    cmd += getObjName();
-    cmd += ".txt=\"";
-    cmd += buffer;
-    cmd += "\"";
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();    
+    return setAttr(__txt, buffer);
 }
\ No newline at end of file
@@ -14,6 +14,12 @@
  */
 #include "NexWaveform.h"
 
+static const NexRefNumAttr __bco = {"bco"};
+static const NexRefNumAttr __gdc = {"gdc"};
+static const NexRefNumAttr __gdw = {"gdw"};
+static const NexRefNumAttr __gdh = {"gdh"};
+static const NexRefNumAttr __pco0 = {"pco0"};
+
 NexWaveform::NexWaveform(uint8_t pid, uint8_t cid, const char *name)
     :NexObject(pid, cid, name)
 {
@@ -36,141 +42,51 @@ bool NexWaveform::addValue(uint8_t ch, uint8_t number)
 
 uint32_t NexWaveform::Get_background_color_bco(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".bco";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__bco, number);
 }
 
 bool NexWaveform::Set_background_color_bco(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".bco=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd="";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__bco, number);
 }
 
 uint32_t NexWaveform::Get_grid_color_gdc(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".gdc";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__gdc, number);
 }
 
 bool NexWaveform::Set_grid_color_gdc(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".gdc=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd="";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__gdc, number);
 }
 
 uint32_t NexWaveform::Get_grid_width_gdw(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".gdw";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__gdw, number);
 }
 
 bool NexWaveform::Set_grid_width_gdw(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".gdw=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd="";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__gdw, number);
 }
 
 uint32_t NexWaveform::Get_grid_height_gdh(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".gdh";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__gdh, number);
 }
 
 bool NexWaveform::Set_grid_height_gdh(uint32_t number)
 {
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".gdh=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd="";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+    return setAttr(__gdh, number);
 }
 
 uint32_t NexWaveform::Get_channel_0_color_pco0(uint32_t *number)
 {
-    String cmd;
-    cmd += "get ";
-    cmd += getObjName();
-    cmd += ".pco0";
-    sendCommand(cmd.c_str());
-    return recvRetNumber(number);
+    return getAttr(__pco0, number);
 }
 
 bool NexWaveform::Set_channel_0_color_pco0(uint32_t number)
-{    
-    char buf[10] = {0};
-    String cmd;
-    
-    utoa(number, buf, 10);
-    cmd += getObjName();
-    cmd += ".pco0=";
-    cmd += buf;
-    sendCommand(cmd.c_str());
-	
-    cmd="";
-    cmd += "ref ";
-    cmd += getObjName();
-    sendCommand(cmd.c_str());
-    return recvRetCommandFinished();
+{
+    return setAttr(__pco0, number);
 }
  
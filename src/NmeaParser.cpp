@@ -0,0 +1,259 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     NmeaParser.cpp
+  Purpose:  Implementation of the streaming NMEA0183 receiver
+*/
+#include "NmeaParser.h"
+
+/*** Converts a hexadecimal character to its value, returns 0xFF if invalid
+*/
+static uint8_t hexValue(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return 0xFF;
+}
+
+NmeaField NmeaSentence::field(uint8_t i) const
+{
+  NmeaField f;
+  if (i >= nrOfFields)
+  {
+    f.ptr = data + len;
+    f.len = 0;
+    return f;
+  }
+  f.ptr = data + fieldStart[i];
+  f.len = fieldStart[i + 1] - fieldStart[i] - 1;
+  return f;
+}
+
+NmeaReceiver::NmeaReceiver()
+    : _buf(NULL), _state(WAIT_START), _checksum(0), _received(0), _hasChecksum(false)
+{
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+void NmeaReceiver::setBuffer(NmeaSentence *buffer)
+{
+  _buf = buffer;
+  _state = WAIT_START;
+}
+
+/*** Appends a character to the buffer, drops the sentence if it is too long
+*/
+void NmeaReceiver::store(char c)
+{
+  if (_buf->len >= NMEA_BUFFER_SIZE - 1)
+  {
+    _stats.overflows++;
+    _state = WAIT_START;
+    return;
+  }
+  _buf->data[_buf->len++] = c;
+}
+
+/*** Terminates the sentence and verifies the checksum
+*/
+bool NmeaReceiver::complete()
+{
+  _state = WAIT_START;
+  _buf->data[_buf->len] = '\0';
+  if (_hasChecksum)
+  {
+    if (_received != _checksum)
+    {
+      _stats.checksumErrors++;
+      return false;
+    }
+  }
+  else
+  {
+#ifdef NMEA_REQUIRE_CHECKSUM
+    _stats.checksumErrors++;
+    return false;
+#else
+    _stats.unchecked++;
+#endif
+  }
+  _stats.sentences++;
+  return true;
+}
+
+bool NmeaReceiver::feed(char c)
+{
+  uint8_t v;
+
+  if (_buf == NULL)
+  {
+    return false;
+  }
+
+  // a start delimiter always starts a new sentence, also to resync on garbage
+  if (c == '$')
+  {
+    _buf->len = 0;
+    _buf->nrOfFields = 1;
+    _buf->fieldStart[0] = 0;
+    _buf->id = 0;
+    _checksum = 0;
+    _received = 0;
+    _hasChecksum = false;
+    _state = IN_DATA;
+    store(c);
+    return false;
+  }
+
+  switch (_state)
+  {
+  case WAIT_START:
+    break;
+
+  case IN_DATA:
+    if (c == '*' || c == '\r' || c == '\n')
+    {
+      // close the last field, it ends where the checksum or line ends
+      _buf->fieldStart[_buf->nrOfFields] = _buf->len + 1;
+      if (c == '\n')
+      {
+        return complete();
+      }
+      if (c == '\r')
+      {
+        _state = WAIT_EOL;
+        break;
+      }
+      _hasChecksum = true;
+      _state = IN_CHECKSUM_HI;
+      store(c);
+      break;
+    }
+    _checksum ^= (uint8_t)c;
+    if (c == ',' && _buf->nrOfFields == 1 && _buf->len >= 4)
+    {
+      // end of the tag, its last 3 chars are the sentence id
+      const char *p = _buf->data + _buf->len - 3;
+      _buf->id = NMEA_ID(p[0], p[1], p[2]);
+    }
+    if (c == ',' && _buf->nrOfFields < NMEA_MAX_FIELDS)
+    {
+      _buf->fieldStart[_buf->nrOfFields++] = _buf->len + 1;
+    }
+    store(c);
+    break;
+
+  case IN_CHECKSUM_HI:
+  case IN_CHECKSUM_LO:
+    v = hexValue(c);
+    if (v == 0xFF)
+    {
+      _stats.checksumErrors++;
+      _state = WAIT_START;
+      break;
+    }
+    _received = (_received << 4) | v;
+    _state = (_state == IN_CHECKSUM_HI) ? IN_CHECKSUM_LO : WAIT_EOL;
+    store(c);
+    break;
+
+  case WAIT_EOL:
+    if (c == '\n')
+    {
+      return complete();
+    }
+    if (c != '\r')
+    {
+      // trailing garbage after the checksum
+      _stats.checksumErrors++;
+      _state = WAIT_START;
+    }
+    break;
+  }
+  return false;
+}
+
+bool nmeaDispatch(const NmeaSentence &sentence, const NmeaDispatch *table, uint8_t count)
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (table[i].id == sentence.id)
+    {
+      table[i].handler(sentence);
+      return true;
+    }
+  }
+  return false;
+}
+
+void nmeaFieldCopy(const NmeaField &field, char *dst, uint8_t size)
+{
+  uint8_t n = field.len;
+  if (size == 0)
+  {
+    return;
+  }
+  if (n > size - 1)
+  {
+    n = size - 1;
+  }
+  memcpy(dst, field.ptr, n);
+  dst[n] = '\0';
+}
+
+bool nmeaFieldTenths(const NmeaField &field, int32_t *tenths)
+{
+  const char *p = field.ptr;
+  const char *end = field.ptr + field.len;
+  bool negative = false;
+  bool digits = false;
+  int32_t value = 0;
+
+  if (p < end && (*p == '-' || *p == '+'))
+  {
+    negative = (*p == '-');
+    p++;
+  }
+  // every multiply-add, and the tenth with its rounding, must stay within
+  // 32 bits: value * 10 + 9 <= INT32_MAX
+  while (p < end && isDigit(*p))
+  {
+    if (value > (INT32_MAX - 9) / 10)
+    {
+      return false;
+    }
+    value = value * 10 + (*p++ - '0');
+    digits = true;
+  }
+  if (value > (INT32_MAX - 9) / 10)
+  {
+    return false;
+  }
+  value *= 10;
+  if (p < end && *p == '.')
+  {
+    p++;
+    if (p < end && isDigit(*p))
+    {
+      value += *p++ - '0';
+      digits = true;
+    }
+    if (p < end && isDigit(*p) && *p >= '5')
+    {
+      value++;
+    }
+    while (p < end && isDigit(*p))
+    {
+      p++;
+    }
+  }
+  if (p != end || !digits)
+  {
+    return false;
+  }
+  *tenths = negative ? -value : value;
+  return true;
+}
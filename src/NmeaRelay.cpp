@@ -0,0 +1,76 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     NmeaRelay.cpp
+  Purpose:  Implementation of the NMEA0183 relay
+*/
+#include "NmeaRelay.h"
+
+NmeaRelay::NmeaRelay(uint32_t bytesPerSecond, uint16_t burst, uint16_t reserve)
+    : _routes(NULL), _nrOfRoutes(0), _rate(bytesPerSecond), _burst(burst * 1000UL),
+      _reserve(reserve * 1000UL), _credit(burst * 1000UL), _lastUs(0)
+{
+  resetStats();
+}
+
+void NmeaRelay::setRoutes(const NmeaRelayRoute *routes, uint8_t count)
+{
+  _routes = routes;
+  _nrOfRoutes = count;
+}
+
+void NmeaRelay::resetStats()
+{
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+uint8_t NmeaRelay::priority(uint32_t id) const
+{
+  for (uint8_t i = 0; i < _nrOfRoutes; i++)
+  {
+    if (_routes[i].id == id)
+    {
+      return _routes[i].priority;
+    }
+  }
+  return NMEA_RELAY_PRIORITIES - 1;
+}
+
+/*** Adds the bytes the link sent since the last refill, at most a burst
+*/
+void NmeaRelay::refill()
+{
+  unsigned long now = micros();
+  unsigned long elapsed = now - _lastUs;
+  _lastUs = now;
+  // the bucket is full after burst / rate seconds, don't overflow the product
+  if (elapsed >= 1000000UL)
+  {
+    _credit = _burst;
+    return;
+  }
+  uint32_t credit = _credit + (uint32_t)((uint64_t)elapsed * _rate / 1000);
+  _credit = credit < _burst ? credit : _burst;
+}
+
+bool NmeaRelay::relay(const NmeaSentence &sentence, Print &out)
+{
+  uint8_t p = priority(sentence.id);
+  if (p >= NMEA_RELAY_PRIORITIES)
+  {
+    p = NMEA_RELAY_PRIORITIES - 1;
+  }
+  refill();
+
+  uint32_t cost = (sentence.len + 2) * 1000UL;
+  if (_credit < cost + p * _reserve)
+  {
+    _stats.dropped[p]++;
+    return false;
+  }
+  _credit -= cost;
+  out.write((const uint8_t *)sentence.data, sentence.len);
+  out.write((const uint8_t *)"\r\n", 2);
+  _stats.relayed[p]++;
+  _stats.bytes += sentence.len + 2;
+  return true;
+}
@@ -0,0 +1,70 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     NmeaRing.cpp
+  Purpose:  Implementation of the lock-free NMEA sentence ring
+*/
+#include "NmeaRing.h"
+
+#define NMEA_RING_MASK (NMEA_RING_SIZE - 1)
+
+NmeaRing::NmeaRing()
+    : _producing(NULL), _head(0), _tail(0), _highWater(0), _overflows(0)
+{
+}
+
+uint8_t NmeaRing::count() const
+{
+  return (uint8_t)(_head - _tail);
+}
+
+NmeaSentence *NmeaRing::producerSlot()
+{
+  if (count() < NMEA_RING_SIZE)
+  {
+    _producing = &_slots[_head & NMEA_RING_MASK];
+  }
+  else
+  {
+    _producing = &_spare;
+  }
+  return _producing;
+}
+
+bool NmeaRing::push()
+{
+  if (_producing != &_slots[_head & NMEA_RING_MASK] || count() >= NMEA_RING_SIZE)
+  {
+    _overflows++;
+    return false;
+  }
+  // make sure the sentence is in memory before the consumer can see it
+  __sync_synchronize();
+  _head = _head + 1;
+
+  uint8_t n = count();
+  if (n > _highWater)
+  {
+    _highWater = n;
+  }
+  return true;
+}
+
+NmeaSentence *NmeaRing::peek()
+{
+  if (_head == _tail)
+  {
+    return NULL;
+  }
+  __sync_synchronize();
+  return &_slots[_tail & NMEA_RING_MASK];
+}
+
+void NmeaRing::release()
+{
+  if (_head == _tail)
+  {
+    return;
+  }
+  __sync_synchronize();
+  _tail = _tail + 1;
+}
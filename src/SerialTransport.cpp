@@ -0,0 +1,84 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     SerialTransport.cpp
+  Purpose:  ESP32 implementations of the serial transport and the default
+            transports of the Nextion library
+*/
+#include "SerialTransport.h"
+#include "NexConfig.h"
+
+#ifndef NATIVE_BUILD
+#include <Preferences.h>
+
+#define NEX_PREFERENCES "nextion" // namespace of the stored baudrate
+
+UartTransport::UartTransport(HardwareSerial &uart, int8_t rxPin, int8_t txPin, bool invert)
+    : _uart(uart), _rxPin(rxPin), _txPin(txPin), _invert(invert), _baud(0), _rxBufferSize(0)
+{
+}
+
+void UartTransport::begin(uint32_t baud)
+{
+  if (_baud != 0)
+  {
+    _uart.updateBaudRate(baud);
+  }
+  else
+  {
+    if (_rxBufferSize > 0)
+    {
+      // the driver allocates the buffer in begin()
+      _uart.setRxBufferSize(_rxBufferSize);
+    }
+    _uart.begin(baud, SERIAL_8N1, _rxPin, _txPin, _invert);
+  }
+  _baud = baud;
+}
+
+uint32_t UartTransport::baudRate()
+{
+  return _baud;
+}
+
+SoftSerialTransport::SoftSerialTransport(SoftwareSerial &serial, int8_t rxPin, int8_t txPin, bool invert)
+    : _serial(serial), _rxPin(rxPin), _txPin(txPin), _invert(invert), _baud(0)
+{
+}
+
+void SoftSerialTransport::begin(uint32_t baud)
+{
+  _serial.begin(baud, SWSERIAL_8N1, _rxPin, _txPin, _invert);
+  _baud = baud;
+}
+
+uint32_t SoftSerialTransport::baudRate()
+{
+  return _baud;
+}
+
+//*** default links of the Nextion library, see NexConfig.h
+UartTransport debugUart(Serial);
+UartTransport nextionUart(Serial2, NEX_RX_PIN, NEX_TX_PIN);
+
+SerialTransport *dbTransport = &debugUart;
+SerialTransport *nexTransport = &nextionUart;
+
+//*** the baudrate of the display link survives a restart in the NVS
+uint32_t nexLoadBaud()
+{
+  Preferences preferences;
+  preferences.begin(NEX_PREFERENCES, true);
+  uint32_t baud = preferences.getUInt("baud", 0);
+  preferences.end();
+  return baud;
+}
+
+void nexSaveBaud(uint32_t baud)
+{
+  Preferences preferences;
+  preferences.begin(NEX_PREFERENCES, false);
+  preferences.putUInt("baud", baud);
+  preferences.end();
+}
+
+#endif
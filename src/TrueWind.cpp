@@ -0,0 +1,194 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     TrueWind.cpp
+  Purpose:  Implementation of the fixed-point true wind kernel
+*/
+#include "TrueWind.h"
+
+//*** sin(0..90 degrees) in steps of 1 degree as Q15
+static const int16_t sinTable[91] = {
+    0, 572, 1144, 1715, 2286, 2856, 3425, 3993, 4560, 5126,
+    5690, 6252, 6813, 7371, 7927, 8481, 9032, 9580, 10126, 10668,
+    11207, 11743, 12275, 12803, 13328, 13848, 14365, 14876, 15384, 15886,
+    16384, 16877, 17364, 17847, 18324, 18795, 19261, 19720, 20174, 20622,
+    21063, 21498, 21926, 22348, 22763, 23170, 23571, 23965, 24351, 24730,
+    25102, 25466, 25822, 26170, 26510, 26842, 27166, 27482, 27789, 28088,
+    28378, 28660, 28932, 29197, 29452, 29698, 29935, 30163, 30382, 30592,
+    30792, 30983, 31164, 31336, 31499, 31651, 31795, 31928, 32052, 32166,
+    32270, 32365, 32449, 32524, 32588, 32643, 32688, 32723, 32748, 32763,
+    32767,
+};
+
+//*** atan(0..1) in steps of 1/64 in hundredths of degrees
+static const int16_t atanTable[65] = {
+    0, 90, 179, 268, 358, 447, 536, 624, 713, 800,
+    888, 975, 1062, 1148, 1234, 1319, 1404, 1488, 1571, 1653,
+    1735, 1817, 1897, 1977, 2056, 2134, 2211, 2287, 2363, 2438,
+    2511, 2584, 2657, 2728, 2798, 2867, 2936, 3003, 3070, 3136,
+    3201, 3264, 3327, 3390, 3451, 3511, 3571, 3629, 3687, 3744,
+    3800, 3855, 3909, 3963, 4016, 4067, 4119, 4169, 4218, 4267,
+    4315, 4363, 4409, 4455, 4500,
+};
+
+/*** Returns the angle in tenths within 0..3599
+*/
+static int32_t normalize(int32_t tenths)
+{
+  tenths %= 3600;
+  return tenths < 0 ? tenths + 3600 : tenths;
+}
+
+int16_t twSin(int32_t tenths)
+{
+  int32_t a = normalize(tenths);
+  uint8_t quadrant = a / 900;
+  int32_t r = a % 900;
+  if (quadrant & 1)
+  {
+    r = 900 - r;
+  }
+  uint8_t i = r / 10;
+  int32_t v = sinTable[i];
+  if (r % 10 != 0)
+  {
+    v += (sinTable[i + 1] - v) * (r % 10) / 10;
+  }
+  return quadrant >= 2 ? -v : v;
+}
+
+int16_t twCos(int32_t tenths)
+{
+  return twSin(tenths + 900);
+}
+
+int16_t twAtan2(int32_t y, int32_t x)
+{
+  if (x == 0 && y == 0)
+  {
+    return 0;
+  }
+  uint32_t ax = x < 0 ? -x : x;
+  uint32_t ay = y < 0 ? -y : y;
+  bool swapped = ay > ax;
+  if (swapped)
+  {
+    uint32_t t = ax;
+    ax = ay;
+    ay = t;
+  }
+  // the ratio in 1/4096, so 6 bits are left to interpolate between entries
+  uint32_t ratio = (ay << 12) / ax;
+  uint8_t i = ratio >> 6;
+  int32_t h = atanTable[i];
+  if (ratio & 63)
+  {
+    h += (atanTable[i + 1] - h) * (int32_t)(ratio & 63) / 64;
+  }
+  if (swapped)
+  {
+    h = 9000 - h;
+  }
+  if (x < 0)
+  {
+    h = 18000 - h;
+  }
+  h = (h + 5) / 10;
+  return y < 0 ? -h : h;
+}
+
+uint16_t twSqrt(uint32_t value)
+{
+  if (value == 0)
+  {
+    return 0;
+  }
+  // start at the highest even power of 2 in value, clz is one instruction
+  uint32_t root = 0;
+  uint32_t bit = 1UL << ((31 - __builtin_clz(value)) & ~1);
+  while (bit != 0)
+  {
+    if (value >= root + bit)
+    {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+    {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+void twCalculate(int32_t aws, int32_t awa, int32_t sog, int32_t cog, TrueWind *tw)
+{
+  aws = constrain(aws, 0, TW_MAX_SPEED);
+  sog = constrain(sog, 0, TW_MAX_SPEED);
+
+  // the vector in 1/16 of tenths, |x|,|y| <= 2 * TW_MAX_SPEED * 16 so the
+  // sum of the squares stays within 32 bits
+  int32_t x = ((aws * twCos(awa) + 1024) >> 11) - (sog << 4);
+  int32_t y = (aws * twSin(awa) + 1024) >> 11;
+  uint32_t ax = x < 0 ? -x : x;
+  uint32_t ay = y < 0 ? -y : y;
+  uint32_t squares = ax * ax + ay * ay;
+  int32_t r = twSqrt(squares);
+  if (squares - (uint32_t)r * r > (uint32_t)r)
+  {
+    // rounded to the nearest, r is also the divisor of the VMG
+    r++;
+  }
+  tw->tws = (r + 8) >> 4;
+  tw->twa = tw->tws > 0 ? twAtan2(y, x) : 0;
+  tw->twd = normalize(cog + tw->twa);
+  // cos(TWA) is x / r, rounded away from 0 like the other outputs
+  int32_t v = sog * x;
+  tw->vmg = r > 0 ? (v + (v < 0 ? -r / 2 : r / 2)) / r : 0;
+}
+
+WindHistory::WindHistory()
+{
+  clear();
+}
+
+void WindHistory::clear()
+{
+  _sumX = _sumY = 0;
+  _head = _count = 0;
+}
+
+void WindHistory::add(int32_t tws, int32_t twd)
+{
+  if (_count == TW_HISTORY)
+  {
+    _sumX -= _x[_head];
+    _sumY -= _y[_head];
+  }
+  else
+  {
+    _count++;
+  }
+  _tws[_head] = tws;
+  _x[_head] = twCos(twd);
+  _y[_head] = twSin(twd);
+  _sumX += _x[_head];
+  _sumY += _y[_head];
+  _head = (_head + 1) % TW_HISTORY;
+}
+
+int16_t WindHistory::meanDirection() const
+{
+  // 64 samples of Q15 fit in 2^21, twAtan2 takes less than 2^19
+  return normalize(twAtan2(_sumY >> 2, _sumX >> 2));
+}
+
+int32_t WindHistory::maxSpeed() const
+{
+  int32_t max = 0;
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    max = _tws[i] > max ? _tws[i] : max;
+  }
+  return max;
+}
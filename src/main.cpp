@@ -51,7 +51,21 @@
 
         2)  Rx2(GPIO 16) and TX2(GPIO 17) are reserved for the display communication 115200Bd
             Digital GPIO 22 (and 23) are reserved for NMEA talker via
-            SoftSerial on 4800 Bd
+            SoftSerial on 4800 Bd, or via UART1 remapped to these pins
+            with NMEA_INPUT_UART
+  
+        3)  The HMI project is Nextion/Yazz_winddisplay_7inch_ser_white_180.HMI,
+            a file of the Nextion Editor. The frames with the values go to its
+            text component nmea on page 1, which needs a txt_maxl of at least
+            HMI_TXT_MAXL (204) for a frame with all keys. The HMI code must
+            parse all keys of HmiFrame.h, also TWA, TWD, VMG, MWD and MXW.
+            MXW is the highest TWS of the 10 s samples in the wind history,
+            not a gust.
+
+        4)  The link to the HMI runs at NEX_BAUD, 115200 Bd. Build with
+            -DNEXTION_BAUD=921600 to negotiate a faster link at boot, see
+            nexNegotiateBaud(). That sends bauds= to the HMI, which changes
+            its power on rate for good, and stores the rate in the NVS.
   
   Hardware setup:
   The ESP32 has 3 Rx/Tx portsand has to be set to Serial2 
@@ -89,39 +103,86 @@
   such as navigation at sea.  
         
   TO DO:    - Connect HMI to 5V from the Buck converter i.s.o. 3.3V pin on ESP32
-            -Implement 2-way communication so that incomming NMEA data can be relayed
-            to other devices. An NMEA0183 network is typically a daisy chained network
 
   LIMITATIONS: 
-            As per the Arduino Nano V1.13;No relay of NMEA0183 data possible currently. 
-            So display needs to be implemented as the last node in the daisy chain.
+            An NMEA0183 network is typically a daisy chained network. With
+            WRITE_ENABLED the received sentences are relayed on NMEA_TX, see
+            NmeaRelay.h; without it the display needs to be implemented as
+            the last node in the daisy chain.
+            The relay is limited to the 4800 Bd of the output, when the
+            talkers send more the wind and speed go first, then depth, then
+            battery and then all other sentences.
+            The relay needs the NMEA input on UART1, NMEA_INPUT_UART.
+            SoftwareSerial writes bit by bit while the caller waits, which
+            would stall the reception; when NMEA_SELECT_PIN selects it the
+            relay is off.
  
   Credit:   
 */
 
-#include <HardwareSerial.h>
 //*** Include the Nextion Display files here
 
 //*** Since the ESP32 has only one(out of 3) Rx/Tx port free we need SoftwareSerial to
 //*** setup the serial communciation with the NMEA0183 network
-#include <SoftwareSerial.h>
+//*** All serial links are used through a SerialTransport so this file also
+//*** builds for Linux in the native environment
+#include "SerialTransport.h"
 #include <Nextion.h> //All other Nextion classes come with this libray
+#include "NmeaParser.h"
+#include "NmeaRing.h"
+#include "NmeaRelay.h"
+#include "SpscQueue.h"
+#include "NavState.h"
+#include "HmiFrame.h"
+#include "TrueWind.h"
 
 //*** Definitions goes here
 
-//For testing  and development purposes only outcomment to disable
+//Relays the received NMEA sentences to the next device on NMEA_TX; out comment to disable
 //#define WRITE_ENABLED 1
 #define VERSION "1.35"
 #define NEXTION_ATTACHED 1 //out comment if no display available
+//#define PIPELINED_MODE 1  //NMEA ingest on core 0, display on core 1; out comment for 1 core
+//#define ISR_STATS 1       //prints the interrupt load of the NMEA input, stalls a core ISR_SAMPLE ms per STATS_INTERVAL
+//#define TRUEWIND_BENCH 1  //prints the cycles of the true wind kernel and of the float calculation at start
+#if defined(PIPELINED_MODE) && defined(NATIVE_BUILD)
+#undef PIPELINED_MODE // needs the FreeRTOS of the ESP32
+#endif
+#if defined(WRITE_ENABLED) && !defined(NMEA_INPUT_UART) && !defined(NATIVE_BUILD)
+#error "WRITE_ENABLED needs NMEA_INPUT_UART, SoftwareSerial blocks while it writes"
+#endif
+#if defined(ISR_STATS) && defined(NATIVE_BUILD)
+#undef ISR_STATS // there are no interrupts in the native build
+#endif
+#if defined(TRUEWIND_BENCH) && defined(NATIVE_BUILD)
+#undef TRUEWIND_BENCH // the native build times the kernel with -w
+#endif
 
 #define NMEA_BAUD 4800      //baudrate for NMEA communciation
-#define NMEA_BUFFER_SIZE 83 // According NEA0183 specs the max char is 82 + '\0'
 #define NMEA_RX 22
 #define NMEA_TX 23
+//#define NMEA_INPUT_UART 1   //NMEA on hardware UART1 i.s.o. SoftwareSerial
+#define NMEA_UART_BUFFER 1024 //receive buffer of UART1, filled by the UART driver
+#define NMEA_SELECT_PIN -1    //pulled low at start selects the other NMEA input; -1 for none
+#define ISR_SAMPLE 50         //ms the interrupt load is sampled with ISR_STATS
+#define TRUEWIND_RUNS 1000    //calculations timed with TRUEWIND_BENCH
+#define NMEA_RELAY_RATE (NMEA_BAUD / 10) //bytes/s the relay may send, 8N1
+#define NMEA_RELAY_BURST 128  //most bytes relayed at once, the UART TX FIFO
+#define NMEA_RELAY_RESERVE 12 //bytes kept free for each higher relay priority
 #define NEXTION_RX (int8_t)16
 #define NEXTION_TX (int8_t)17
 #define NEXTION_RCV_DELAY 100
 #define NEXTION_SND_DELAY 50
+#define NEXTION_WINDOW 4 //nr of commands in flight to the HMI, 0 to wait for every reply
+#ifndef NEXTION_BAUD
+#define NEXTION_BAUD 0 //rate negotiated with the HMI, 0 to keep NEX_BAUD, see NOTES 4)
+#endif
+#define BOOT_PROBE 250           //ms between the sendme's asking a running HMI for its page
+#define BOOT_READY_TIMEOUT 5000  //ms to wait for the HMI to report it is ready
+#define BOOT_RETRIES 2           //resets of an HMI that doesn't reply
+#define BOOT_SPLASH 1000         //ms the version is shown on the splash page
+#define BOOT_STATUS_POLL 50      //ms between the polls of the status picture
+#define BOOT_STATUS_TIMEOUT 20000 //ms the selftest of the HMI may take
 
 #define RED 63488  //Nextion color
 #define GREEN 2016 //Nextion color
@@ -130,25 +191,36 @@
 #define WINDDISPLAY_STATUS "status"
 #define WINDDISPLAY_STATUS_VALUE "winddisplay.status.val"
 #define WINDDISPLAY_NMEA "nmea"
-#define FIELD_BUFFER 15 //nr of char used for displaying info on Nextion
 
-#define FTM 0.3048 //conversion from feet to meter
+#define FTM 3048 //conversion from feet to meter, times 10000
+
+#define INGEST_CORE 0         //core running the NMEA ingest task in PIPELINED_MODE
+#define INGEST_STACK 4096     //stack size of the NMEA ingest task
+#define INGEST_PRIORITY 2     //just above the Arduino loop task
+#define NAV_QUEUE_SIZE 16     //parsed values in transit between the cores, power of 2
+#define STATS_INTERVAL 10000  //ms between printing the pipeline statistics
+#define WIND_HISTORY_INTERVAL 10000 //ms between the samples of the wind history, TW_HISTORY of them
 
 //*** Global scope variable declaration goes here
 NexPicture dispStatus = NexPicture(1, 35, WINDDISPLAY_STATUS);
 NexText nmeaTxt = NexText(1, 16, WINDDISPLAY_NMEA);
 NexText versionTxt = NexText(0,3,"version");
-SoftwareSerial nmeaSerial;
-
-char _AWA[FIELD_BUFFER] = {0};
-char _COG[FIELD_BUFFER] = {0};
-char _SOG[FIELD_BUFFER] = {0};
-char _AWS[FIELD_BUFFER] = {0};
-char _BAT[FIELD_BUFFER] = {0};
-char _DPT[FIELD_BUFFER] = {0};
-char _DIR[FIELD_BUFFER] = {0};
-char _TWS[FIELD_BUFFER] = {0};
-char oldVal[255] = {0}; // holds previos _BITVALUE to check if we need to send
+#ifndef NATIVE_BUILD
+SoftwareSerial nmeaSoftSerial;
+SoftSerialTransport nmeaSoftTransport(nmeaSoftSerial, NMEA_RX, NMEA_TX, true);
+UartTransport nmeaUartTransport(Serial1, NMEA_RX, NMEA_TX, true);
+#ifdef NMEA_INPUT_UART
+SerialTransport *nmeaTransport = &nmeaUartTransport;
+#else
+SerialTransport *nmeaTransport = &nmeaSoftTransport;
+#endif
+#else
+SerialTransport *nmeaTransport = NULL; // set by the native main before setup()
+#endif
+#define nmeaSerial (*nmeaTransport)
+
+NavState navState;           // parsed values, in tenths
+HmiFrame hmiFrame;           // sends only the values that changed
 
 enum nextionStatus
 {
@@ -157,35 +229,117 @@ enum nextionStatus
   HMI_READY = 5
 };
 
-char cvalue[FIELD_BUFFER] = {0};
-uint16_t tmpVal = 0;
+//*** steps of the start of the HMI, see bootDisplay()
+enum bootState
+{
+  BOOT_WAIT_READY,  // waiting for the HMI to report it is ready
+  BOOT_FIND_BAUD,   // probing the baudrates, one per pass
+  BOOT_INIT,        // setting up the communication
+  BOOT_SPLASH_PAGE, // showing the version on the splash page
+  BOOT_WAIT_STATUS, // waiting for the selftest of the HMI
+  BOOT_DONE         // frames are sent
+};
+
+bootState bootStep = BOOT_WAIT_READY;
+unsigned long bootTmr = 0;      // start of the current boot step
+unsigned long bootPollTmr = 0;  // last probe or status poll
+uint8_t bootRetries = 0;
+uint8_t bootBaudStep = 0;       // next step of nexFindBaudStep()
+uint32_t bootBaud = 0;          // rate the HMI replied at, 0 if none
+bool hmiReady = false;          // set by the ready or page event of the HMI
+bool bootProbed = false;        // a sendme is not answered yet
+unsigned long firstFrameMs = 0; // ms from the start to the first frame, 0 until sent
 
-unsigned int ci = 0; // current index of ',' to iterate through received NMEA data
-unsigned int li = 0; // last index of ',' in NMEA buffer
-uint16_t cp = 0;     //current index pointer in an array
-int field = 0;
 bool updateDisplay = false;
 
-const byte numChars = NMEA_BUFFER_SIZE;
-char receivedChars[numChars];
+NmeaReceiver nmeaReceiver;
+NmeaRing nmeaRing; // received and validated sentences waiting to be parsed
+#ifdef WRITE_ENABLED
+NmeaRelay nmeaRelay(NMEA_RELAY_RATE, NMEA_RELAY_BURST, NMEA_RELAY_RESERVE);
+#endif
 
-bool newData = false;
 unsigned long tmr1 = 0;
+WindHistory windHistory;      // TWS and TWD of the last minutes
+unsigned long historyTmr = 0; // last sample of the wind history
+
+#ifdef PIPELINED_MODE
+//*** a parsed value on its way from the ingest task to the display loop
+struct NavUpdate
+{
+  uint8_t key;
+  bool valid;
+  int32_t tenths;
+};
+
+//*** busy time of a task, to calculate its CPU load per STATS_INTERVAL
+struct TaskStats
+{
+  volatile uint32_t busyUs;
+  volatile uint32_t runs;
+};
+
+SpscQueue<NavUpdate, NAV_QUEUE_SIZE> navQueue;
+TaskStats ingestStats = {0, 0};
+TaskStats displayStats = {0, 0};
+volatile bool ingestStatsReset = false; // the ingest task clears its counters, set by printStats
+unsigned long statsTmr = 0;
+#endif
+
+/*** Calculates TWS, TWA and VMG towards the wind from AWA, AWS and SOG,
+ * and TWD with COG, which stands in for the heading; invalid if one of
+ * their inputs is. VMG is negative when running.
+*/
+void deriveTrueWind(NavState &state)
+{
+  if (!state.valid(NAV_SOG) || !state.valid(NAV_AWA) || !state.valid(NAV_AWS))
+  {
+    state.invalidate(NAV_TWS);
+    state.invalidate(NAV_TWA);
+    state.invalidate(NAV_VMG);
+    state.invalidate(NAV_TWD);
+    return;
+  }
+  // in fixed-point on the tenths, all from one vector, see TrueWind.h
+  TrueWind tw;
+  bool cog = state.valid(NAV_COG);
+  twCalculate(state.tenths(NAV_AWS), state.tenths(NAV_AWA), state.tenths(NAV_SOG),
+              cog ? state.tenths(NAV_COG) : 0, &tw);
+  state.set(NAV_TWS, tw.tws);
+  state.set(NAV_TWA, tw.twa);
+  state.set(NAV_VMG, tw.vmg);
+  if (cog)
+  {
+    state.set(NAV_TWD, tw.twd);
+  }
+  else
+  {
+    state.invalidate(NAV_TWD);
+  }
+}
 
-/*** function check if a string is a number
+/*** Adds the true wind to the history every WIND_HISTORY_INTERVAL and
+ * sets its mean direction and highest speed
 */
-boolean isNumeric(char *value)
+void sampleWindHistory(unsigned long now)
 {
-  boolean result = true;
-  int i = 0;
-  while (value[i] != '\0' && result && i < FIELD_BUFFER)
+  if (historyTmr != 0 && now - historyTmr < WIND_HISTORY_INTERVAL)
+  {
+    return;
+  }
+  if (!navState.valid(NAV_TWS) || !navState.valid(NAV_TWD))
   {
-    result = (isDigit(value[i]) || value[i] == '.' || value[i] == '-');
-    i++;
+    return;
   }
-  return result;
+  historyTmr = now;
+  windHistory.add(navState.tenths(NAV_TWS), navState.tenths(NAV_TWD));
+  navState.set(NAV_MWD, windHistory.meanDirection());
+  navState.set(NAV_MXW, windHistory.maxSpeed());
 }
 
+//*** the derived values, a node after the nodes its inputs come from
+const NavNode navNodes[] = {
+    {NAV_BIT(NAV_AWA) | NAV_BIT(NAV_AWS) | NAV_BIT(NAV_SOG) | NAV_BIT(NAV_COG), deriveTrueWind},
+};
 
 /*** Converts and adjusts the incomming values to usable values for the HMI display 
  * and concatenates these values in one string so it can be send in one command to the 
@@ -196,94 +350,57 @@ boolean isNumeric(char *value)
  * The string is formatted like:
  * <Sentence ID1>=<Value1>#....<Sentence IDn>=<Value_n>#
  * Sentence ID = 3 chars i.e. SOG, COG etc
- * Value can be an integer or float with 1 decimal and max 5 char long incl. delimiter
- * i.e. SOG=6.4#COG=213.2#BAT=12.5#AWA=37#AWS=15.7#
- * The order is not applicable, so can be random
+ * Value is a number with 1 decimal
+ * i.e. SOG=6.4#COG=213.2#BAT=12.5#AWA=37.0#AWS=15.7#
+ * The order is not applicable, so can be random, and only the values that
+ * changed since the previous frame are send, see HmiFrame.h for the keys and
+ * the txt_maxl the HMI needs
  */
 void displayData()
 {
-  char _BITVAL[255] = {0};
-
-  // if cog is a number
-  if (isNumeric(_COG))
-  {
-    strcat(_BITVAL, "COG=");
-    strcat(_BITVAL, _COG);
-    strcat(_BITVAL, "#");
-  }
-
-  //set awa if is a number
-  if (isNumeric(_AWA))
-  {
-    strcat(_BITVAL, "AWA=");
-    strcat(_BITVAL, _AWA);
-    strcat(_BITVAL, "#");
-  }
-
-  //set sog if is a number
-  if (isNumeric(_SOG))
-  {
-    strcat(_BITVAL, "SOG=");
-    strcat(_BITVAL, _SOG);
-    strcat(_BITVAL, "#");
-  }
+  char _BITVAL[HMI_FRAME_SIZE];
 
-  // set aws is is a number
-  if (isNumeric(_AWS))
+  //*** Nextion display timer max speed is 50ms
+  // so no need to send faster than 50ms otherwise
+  // flooding the serialbuffer
+  if (millis() - tmr1 <= NEXTION_SND_DELAY)
   {
-    strcat(_BITVAL, "AWS=");
-    strcat(_BITVAL, _AWS);
-    strcat(_BITVAL, "#");
+    return;
   }
+  tmr1 = millis();
 
-  // set BATT is is a number
-  if (isNumeric(_BAT))
+  if (bootStep != BOOT_DONE)
   {
-    strcat(_BITVAL, "BAT=");
-    strcat(_BITVAL, _BAT);
-    strcat(_BITVAL, "#");
+    // the values are sent as soon as the HMI is ready
+    return;
   }
-  // set dpt is is a number
-  if (isNumeric(_DPT))
-  {
-    strcat(_BITVAL, "DPT=");
-    strcat(_BITVAL, _DPT);
-    strcat(_BITVAL, "#");
-  }
-  // Calculate TWS from AWA and SOG as described Starpath TrueWind by, David Burch, 2000
-  // TWS= SQRT( SOG^2*AWS^2 + (2*SOG*AWA*COS(AWA/180)))
-  double sog, awa, aws, tws = 0.0;
-  sog = atof(_SOG);
-  awa = atof(_AWA);
-  aws = atof(_AWS);
-  tws= sqrt( sog*sog + aws*aws -(2*sog*aws*cos((double)awa*PI/180)));
-  sprintf(_TWS,"%.1f" ,tws);
-  strcat(_BITVAL,"TWS=");
-  strcat(_BITVAL,_TWS);
-  strcat(_BITVAL,"#");
-  //*** Nextion display timer max speed is 50ms
-  // so no need to send faster than 50ms otherwise
-  // flooding the serialbuffer
-  if (millis() - tmr1 > NEXTION_SND_DELAY)
-  {
-    tmr1 = millis();
+  // only the values of which an input changed since the last frame are
+  // derived, and only the changed values are formatted
+  navState.derive();
+  sampleWindHistory(tmr1);
+  uint8_t len = hmiFrame.encode(navState, tmr1, _BITVAL);
+  navState.clean();
 #ifdef NEXTION_ATTACHED
 
-    if (strcmp(oldVal, _BITVAL) != 0)
+  if (len > 0)
+  {
+    dbSerial.print("Sending NMEA data: ");
+    // all component updates of a frame go out in one write
+    nexBatchBegin();
+    nmeaTxt.setText(_BITVAL);
+    nexBatchEnd();
+    dbSerial.println(_BITVAL);
+    if (firstFrameMs == 0)
     {
-      
-      strcpy(oldVal, _BITVAL);
-
-  
-      dbSerial.print("Sending NMEA data: ");
-      nmeaTxt.setText(_BITVAL);
-      dbSerial.println(_BITVAL);
+      firstFrameMs = tmr1;
+      dbSerial.print("First frame after ms: ");
+      dbSerial.println(firstFrameMs);
     }
+  }
 
 #endif
 
-    newData = false;
-  }
+  updateDisplay = false;
 }
 
 #ifdef NEXTION_ATTACHED
@@ -298,177 +415,607 @@ void hmiCommtest(uint16_t t0)
   dbSerial.print(" Setting HMI to OK:");
   dispStatus.setPic(HMI_READY);
 }
-#endif
 
+/*** The HMI is ready after power on, or it is already running when it
+ * replies to the sendme probe with its page
+*/
+void onHmiEvent(uint8_t code)
+{
+  if (code == NEX_EVENT_READY)
+  {
+    hmiReady = true;
+  }
+}
+
+void onHmiPage(uint8_t /* pid */)
+{
+  hmiReady = true;
+  bootProbed = false;
+}
 
+const NexHandlers hmiHandlers = {onHmiPage, NULL, onHmiEvent, NULL, NULL, NULL};
+
+void nextBootStep(bootState step)
+{
+  bootStep = step;
+  bootTmr = millis();
+  // the first probe or status poll of a step is due at once
+  bootPollTmr = bootTmr - BOOT_PROBE;
+}
 
-/** reads the softseroal port pin 10 and ckeks for valid nmea data starting with
- * character '$' only (~ and ! can be skipped as start charcter)
+/*** Starts the HMI one step at a time, called from loop() until it is done
+ * so the NMEA data is received in the meantime. Every step waits for a
+ * reply of the HMI, with a timeout, instead of a fixed time:
+ * - the ready event after power on, or the reply to a sendme
+ * - the reply to bkcmd at one of the baudrates, one rate per call
+ * - the replies to bkcmd and the page changes
+ * - the status picture, set to HMI_OK by the HMI after its selftest
+ * An HMI that doesn't reply is reset up to BOOT_RETRIES times.
 */
-void recvNMEAData()
+void bootDisplay()
 {
-  static bool recvInProgress = false;
-  static byte ndx = 0;
-  char startMarker = '$';
-  char endMarker = '\n';
-  char rc;
-  while (nmeaSerial.available() > 0 && newData == false)
+  unsigned long elapsed = millis() - bootTmr;
+  bool ok;
+
+  switch (bootStep)
   {
-    rc = nmeaSerial.read();
-    if (recvInProgress == true)
+  case BOOT_WAIT_READY:
+    // the events are received by nexAsyncPoll() in loop()
+    if (elapsed > BOOT_READY_TIMEOUT)
+    {
+      nextBootStep(BOOT_FIND_BAUD);
+    }
+    else if (!hmiReady)
+    {
+      if (millis() - bootPollTmr >= BOOT_PROBE)
+      {
+        bootPollTmr = millis();
+        bootProbed = true;
+        sendCommand("sendme");
+      }
+    }
+    else if (!bootProbed || millis() - bootPollTmr > NEXTION_RCV_DELAY)
+    {
+      // a sendme sent just before the ready event may still be answered,
+      // which would be taken for the reply to the next command
+      nextBootStep(BOOT_FIND_BAUD);
+    }
+    break;
+  case BOOT_FIND_BAUD:
+    // the HMI may still run at another rate than the stored one, every
+    // rate that doesn't reply takes 100ms
+    bootBaudStep = nexFindBaudStep(bootBaudStep, &bootBaud);
+    if (bootBaudStep == 0)
+    {
+      nextBootStep(BOOT_INIT);
+    }
+    break;
+  case BOOT_INIT:
+    ok = bootBaud != 0;
+    if (ok && NEXTION_BAUD > 0)
+    {
+      dbSerial.print("HMI baudrate: ");
+      dbSerial.println(nexNegotiateBaud(NEXTION_BAUD));
+    }
+    sendCommand("page 0");
+    ok = recvRetCommandFinished(NEXTION_RCV_DELAY) && ok;
+    if (!ok && bootRetries < BOOT_RETRIES)
+    {
+      bootRetries++;
+      dbSerial.println("Initialisation failed...");
+      dbSerial.println("Resetting Nextion...");
+      hmiReady = false;
+      sendCommand("rest");
+      nextBootStep(BOOT_WAIT_READY);
+      break;
+    }
+    dbSerial.println(ok ? "Initialisation succesful...." : "Initialisation failed...");
+    dbSerial.print(" Writing version to splash: ");
+    versionTxt.setText(VERSION);
+    nextBootStep(BOOT_SPLASH_PAGE);
+    break;
+  case BOOT_SPLASH_PAGE:
+    if (elapsed >= BOOT_SPLASH)
+    {
+      dbSerial.print("Switcing to page 1: ");
+      sendCommand("page 1");
+      recvRetCommandFinished(NEXTION_RCV_DELAY);
+      dbSerial.print("Getting HMI status:");
+      nextBootStep(BOOT_WAIT_STATUS);
+    }
+    break;
+  case BOOT_WAIT_STATUS:
+    if (millis() - bootPollTmr >= BOOT_STATUS_POLL)
     {
-      if (rc != endMarker)
+      uint32_t displayReady = SELFTEST;
+      bootPollTmr = millis();
+      dbSerial.print(".");
+      if (!dispStatus.getPic(&displayReady) || displayReady < HMI_OK)
       {
-        receivedChars[ndx] = rc;
-        ndx++;
-        if (ndx >= numChars)
+        if (elapsed < BOOT_STATUS_TIMEOUT)
         {
-          ndx = numChars - 1;
+          break;
         }
+        dbSerial.println("HMI status timeout");
       }
-      else
+      hmiCommtest(45);
+      // from now on the frames go out without waiting for the HMI to reply
+      if (NEXTION_WINDOW > 0 && !nexAsyncBegin(NEXTION_WINDOW))
       {
-        receivedChars[ndx] = '\0'; // terminate the string
-
-        recvInProgress = false;
-        ndx = 0;
-        newData = true;
+        dbSerial.println("Asynchronous commands not accepted");
       }
+      dbSerial.print("HMI ready after ms: ");
+      dbSerial.println(millis());
+      nextBootStep(BOOT_DONE);
+      // the first frame has all values, or their placeholder if nothing is
+      // received yet
+      updateDisplay = true;
     }
+    break;
+  case BOOT_DONE:
+    break;
+  }
+}
+#endif
 
-    else if (rc == startMarker)
+
+
+/** reads the softserial port and feeds every byte to the NMEA receiver which
+ * checks for valid nmea data starting with character '$' only
+ * (~ and ! can be skipped as start charcter), splits it in fields and
+ * verifies the checksum while receiving.
+ * Completed sentences are queued in the ring so reading never stops,
+ * not even while the display is being updated.
+*/
+void recvNMEAData()
+{
+  // a slot may have been released since the ring was full
+  if (nmeaReceiver.idle() && nmeaReceiver.buffer() != nmeaRing.producerSlot())
+  {
+    nmeaReceiver.setBuffer(nmeaRing.producerSlot());
+  }
+  while (nmeaSerial.available() > 0)
+  {
+    if (nmeaReceiver.feed(nmeaSerial.read()))
     {
-      receivedChars[ndx] = rc;
-      ndx++;
-      recvInProgress = true;
+      nmeaRing.push();
+      nmeaReceiver.setBuffer(nmeaRing.producerSlot());
     }
   }
 }
 
-/* only processes the receivedChars buffer and filters sentence MWV,RM and VWR,
- * which contain the SOG,COG, AWS and AWA parameters, when new data has arrived
+/*** Selects the NMEA input before it is opened: UART1 or SoftwareSerial as
+ * built, or the other one when NMEA_SELECT_PIN is low, so both can be
+ * compared on the same board without a new build
 */
-void processNMEAData()
+void selectNmeaInput()
 {
+#ifndef NATIVE_BUILD
+  if (NMEA_SELECT_PIN >= 0)
+  {
+    pinMode(NMEA_SELECT_PIN, INPUT_PULLUP);
+    if (digitalRead(NMEA_SELECT_PIN) == LOW)
+    {
+      nmeaTransport = nmeaTransport == &nmeaUartTransport ? (SerialTransport *)&nmeaSoftTransport
+                                                          : (SerialTransport *)&nmeaUartTransport;
+    }
+  }
+  nmeaUartTransport.setRxBufferSize(NMEA_UART_BUFFER);
+  dbSerial.print("NMEA input: ");
+  dbSerial.println(nmeaTransport == &nmeaUartTransport ? "UART1" : "SoftwareSerial");
+#ifdef WRITE_ENABLED
+  if (nmeaTransport != &nmeaUartTransport)
+  {
+    dbSerial.println("NMEA relay off, it needs UART1");
+  }
+#endif
+#endif
+}
 
-  String sentence = "";
-  if (newData == true)
+#ifdef ISR_STATS
+unsigned long isrTmr = 0;
+
+/*** Prints the share of the CPU taken by interrupts on this core every
+ * STATS_INTERVAL. Only for comparing the NMEA inputs, the core doesn't
+ * do anything else while it is sampled. A fixed amount of work is timed for ISR_SAMPLE ms with
+ * the scheduler suspended; every run that took longer than the fastest
+ * one was interrupted for the difference. Called on the core the NMEA
+ * input was opened on, where its interrupts are handled.
+*/
+void sampleIsrLoad()
+{
+  if (millis() - isrTmr < STATS_INTERVAL)
   {
+    return;
+  }
+  isrTmr = millis();
 
-    sentence = String(receivedChars);
+  uint32_t fastest = UINT32_MAX;
+  uint32_t total = 0;
+  uint32_t runs = 0;
+  vTaskSuspendAll();
+  unsigned long start = micros();
+  while (micros() - start < ISR_SAMPLE * 1000UL)
+  {
+    unsigned long t0 = micros();
+    for (volatile uint16_t i = 0; i < 1000; i++)
+    {
+    }
+    uint32_t us = micros() - t0;
+    fastest = us < fastest ? us : fastest;
+    total += us;
+    runs++;
+  }
+  xTaskResumeAll();
 
-    //cvalue='\0';
-    tmpVal = 0;
+  dbSerial.print("NMEA input ISR load%: ");
+  dbSerial.println(total > 0 ? 100.0 * (total - runs * fastest) / total : 0.0);
+}
+#endif
 
-    ci = sentence.indexOf(',', 0);
-    li = sentence.indexOf(',', ci + 1);
-    cp = 0;
+#ifdef TRUEWIND_BENCH
+#include "native/TrueWindRef.h"
 
-    if (sentence.indexOf("MWV", 0) > 0 ||
-        sentence.indexOf("RMC", 0) > 0 ||
-        sentence.indexOf("DBK", 0) > 0 ||
-        sentence.indexOf("TOB", 0) > 0 ||
-        sentence.indexOf("VWR", 0) > 0 ||
-        sentence.indexOf("BAT", 0) > 0 ||
-        sentence.indexOf("DBT", 0) > 0 ||
-        sentence.indexOf("DPT", 0) > 0)
+/*** Prints the mean nr of CPU cycles of one calculation of the true wind
+ * by the fixed-point kernel and by the float calculation it replaced, on
+ * the same pseudo random inputs as the benchmark of the native build. The
+ * time on the host says nothing about the ESP32, which has a single
+ * precision FPU, no double one, and computes sinf() and atan2f() in
+ * software.
+*/
+void benchTrueWind()
+{
+  volatile int32_t sink = 0;
+  uint32_t fixed = 0;
+  uint32_t single = 0;
+  uint32_t seed = 1;
+  for (uint16_t i = 0; i < TRUEWIND_RUNS; i++)
+  {
+    int32_t in[4];
+    for (uint8_t j = 0; j < 4; j++)
     {
-      field = 0; //ignore sentence tag
-      while (li < sentence.length() && li < numChars)
-      {
+      seed = seed * 1103515245 + 12345;
+      in[j] = (seed >> 16) % (j == 1 ? 3600 : 600) - (j == 1 ? 1800 : 0);
+    }
+    TrueWind tw;
+    float ref[4];
+    uint32_t t0 = ESP.getCycleCount();
+    twCalculate(in[0], in[1], in[2], in[3], &tw);
+    uint32_t t1 = ESP.getCycleCount();
+    trueWindFloat(in[0], in[1], in[2], in[3], ref);
+    uint32_t t2 = ESP.getCycleCount();
+    fixed += t1 - t0;
+    single += t2 - t1;
+    sink = sink + tw.tws + (int32_t)ref[0];
+  }
+  dbSerial.print("True wind cycles, fixed: ");
+  dbSerial.print(fixed / TRUEWIND_RUNS);
+  dbSerial.print(" float: ");
+  dbSerial.println(single / TRUEWIND_RUNS);
+}
+#endif
 
-        cp = 0;
-        while (ci + 1 < li)
-        {
-          cvalue[cp++] = sentence[ci + 1];
-          ci++;
-        }
-        cvalue[cp] = '\0';
-        field++;
-        // only check for apparent or relative wind directions and speed
-        if ((sentence.indexOf("MWV") > 0 && sentence.indexOf(",R,") > 0) ||
-            sentence.indexOf("VWR") > 0)
-        {
-          if (field == 1)
-          {
-            memcpy(_AWA, cvalue, FIELD_BUFFER - 1);
-          }
-          if (field == 2)
-          {
-            memcpy(_DIR, cvalue, FIELD_BUFFER - 1);
-            if (_DIR[0] == 'L' || _DIR[0] == 'T')
-            {
-              memmove(_AWA + 1, _AWA, FIELD_BUFFER - 2);
-              _AWA[0] = '-';
-            }
-          }
-          if (field == 3)
-          {
-            memcpy(_AWS, cvalue, FIELD_BUFFER - 1);
-          }
-        }
+/*** Stores a parsed value, or marks it invalid, in the navigation state.
+ * In PIPELINED_MODE the value is queued for the display loop on the other
+ * core, which is the only one touching the navigation state.
+*/
+void publishValue(uint8_t key, bool valid, int32_t tenths)
+{
+#ifdef PIPELINED_MODE
+  NavUpdate update;
+  update.key = key;
+  update.valid = valid;
+  update.tenths = tenths;
+  navQueue.push(update);
+#else
+  if (valid)
+  {
+    navState.set(key, tenths);
+  }
+  else
+  {
+    navState.invalidate(key);
+  }
+  updateDisplay = true;
+#endif
+}
 
-        if (sentence.indexOf("RMC") > 0)
-        {
-          if (field == 7)
-          {
-            memcpy(_SOG, cvalue, FIELD_BUFFER - 1);
-          }
-          if (field == 8)
-          {
-            memcpy(_COG, cvalue, FIELD_BUFFER - 1);
-          }
-        }
-        if (sentence.indexOf("DBK") > 0)
-        {
-          if (field == 2)
-          {
-            memcpy(_DPT, cvalue, FIELD_BUFFER - 1);
-          }
-          if (field == 3 && cvalue[0] == 'f')
-          {
-            double dpt = atof(_DPT);
-            dpt *= FTM;
-            sprintf(_DPT, "%.1f", dpt);
-          }
-        }
-        else if (sentence.indexOf("DBT") > 0)
-        {
-          if (field == 3)
-          {
-            memcpy(_DPT, cvalue, FIELD_BUFFER - 1);
-          }
-        }
-        else if (sentence.indexOf("DPT") > 0)
-        {
-          if (field == 1)
-          {
-            memcpy(_DPT, cvalue, FIELD_BUFFER - 1);
-          }
-        }
-        if (sentence.indexOf("TOB") > 0)
-        {
-          if (field == 1)
-          {
-            memcpy(_BAT, cvalue, FIELD_BUFFER - 1);
-          }
-        }
-        else if (sentence.indexOf("BAT") > 0)
-        {
-          if (field == 2)
-          {
-            memcpy(_BAT, cvalue, FIELD_BUFFER - 1);
-          }
-        }
-        ci = li;
-        li = sentence.indexOf(',', ci + 1);
-        if (li < 0 || li > numChars)
-          li = sentence.length();
-      }
+/*** Publishes the value of a field; invalid if it is empty or not a number
+*/
+void storeField(uint8_t key, const NmeaField &field)
+{
+  int32_t tenths = 0;
+  bool valid = nmeaFieldTenths(field, &tenths);
+  publishValue(key, valid, tenths);
+}
+
+/*** Returns true if field i of sentence s is the single character c
+*/
+bool fieldIs(const NmeaSentence &s, uint8_t i, char c)
+{
+  NmeaField f = s.field(i);
+  return f.len == 1 && f.ptr[0] == c;
+}
+
+/*** Sentence handlers, only called for the sentence type they are
+ * registered for in the dispatch table below
+ */
+void handleApparentWind(const NmeaSentence &s)
+{
+  if (s.nrOfFields < 4)
+  {
+    return;
+  }
+  int32_t awa = 0;
+  bool valid = nmeaFieldTenths(s.field(1), &awa);
+  NmeaField dir = s.field(2);
+  if (dir.len > 0 && (dir.ptr[0] == 'L' || dir.ptr[0] == 'T'))
+  {
+    awa = -awa;
+  }
+  publishValue(NAV_AWA, valid, awa);
+  storeField(NAV_AWS, s.field(3));
+}
+
+// only check for apparent or relative wind directions and speed
+void handleMWV(const NmeaSentence &s)
+{
+  if (fieldIs(s, 2, 'R'))
+  {
+    handleApparentWind(s);
+  }
+}
+
+void handleRMC(const NmeaSentence &s)
+{
+  if (s.nrOfFields > 8)
+  {
+    storeField(NAV_SOG, s.field(7));
+    storeField(NAV_COG, s.field(8));
+  }
+}
+
+void handleDBK(const NmeaSentence &s)
+{
+  // prefer the depth in meters, otherwise convert the depth in feet
+  if (s.field(3).len > 0 && fieldIs(s, 4, 'M'))
+  {
+    storeField(NAV_DPT, s.field(3));
+  }
+  else if (s.field(1).len > 0 && fieldIs(s, 2, 'f'))
+  {
+    int32_t feet = 0;
+    bool valid = nmeaFieldTenths(s.field(1), &feet);
+    // in 64 bits, the product overflows from 70000 feet
+    publishValue(NAV_DPT, valid, (int32_t)(((int64_t)feet * FTM + 5000) / 10000));
+  }
+}
+
+void handleDBT(const NmeaSentence &s)
+{
+  if (s.nrOfFields > 3)
+  {
+    storeField(NAV_DPT, s.field(3));
+  }
+}
+
+void handleDPT(const NmeaSentence &s)
+{
+  storeField(NAV_DPT, s.field(1));
+}
+
+void handleTOB(const NmeaSentence &s)
+{
+  storeField(NAV_BAT, s.field(1));
+}
+
+void handleBAT(const NmeaSentence &s)
+{
+  if (s.nrOfFields > 2)
+  {
+    storeField(NAV_BAT, s.field(2));
+  }
+}
+
+//*** maps the sentence id to its handler, all other sentences are ignored
+const NmeaDispatch nmeaHandlers[] = {
+    {NMEA_ID('M', 'W', 'V'), handleMWV},
+    {NMEA_ID('V', 'W', 'R'), handleApparentWind},
+    {NMEA_ID('R', 'M', 'C'), handleRMC},
+    {NMEA_ID('D', 'B', 'K'), handleDBK},
+    {NMEA_ID('D', 'B', 'T'), handleDBT},
+    {NMEA_ID('D', 'P', 'T'), handleDPT},
+    {NMEA_ID('T', 'O', 'B'), handleTOB},
+    {NMEA_ID('B', 'A', 'T'), handleBAT},
+};
+
+#ifdef WRITE_ENABLED
+//*** relay priority per sentence type, all others get the lowest one
+const NmeaRelayRoute nmeaRoutes[] = {
+    {NMEA_ID('M', 'W', 'V'), 0},
+    {NMEA_ID('V', 'W', 'R'), 0},
+    {NMEA_ID('R', 'M', 'C'), 0},
+    {NMEA_ID('D', 'B', 'K'), 1},
+    {NMEA_ID('D', 'B', 'T'), 1},
+    {NMEA_ID('D', 'P', 'T'), 1},
+    {NMEA_ID('T', 'O', 'B'), 2},
+    {NMEA_ID('B', 'A', 'T'), 2},
+};
+
+/*** Forwards a sentence to the next device in the daisy chain. It is
+ * written from its slot in the ring, so it must be called before the slot
+ * is released.
+*/
+void relayData(const NmeaSentence &sentence)
+{
+#ifndef NATIVE_BUILD
+  if (nmeaTransport != &nmeaUartTransport)
+  {
+    // SoftwareSerial would block the receiver for the whole sentence
+    return;
+  }
+#endif
+  nmeaRelay.relay(sentence, nmeaSerial);
+}
+#endif
+
+/* only processes a received sentence and filters sentence MWV,RM and VWR,
+ * which contain the SOG,COG, AWS and AWA parameters.
+ * The sentence is already validated and split in fields by the receiver, its
+ * type is looked up on the packed sentence id in the tag only.
+*/
+void processNMEAData(const NmeaSentence &sentence)
+{
+  if (sentence.nrOfFields < 2)
+  {
+    return;
+  }
+  nmeaDispatch(sentence, nmeaHandlers, sizeof(nmeaHandlers) / sizeof(nmeaHandlers[0]));
+}
+
+/*** Parses every queued sentence, independent of when the next frame goes out
+*/
+void processNMEAQueue()
+{
+  NmeaSentence *sentence;
+  while ((sentence = nmeaRing.peek()) != NULL)
+  {
+    processNMEAData(*sentence);
+#ifdef WRITE_ENABLED
+    relayData(*sentence);
+#endif
+    nmeaRing.release();
+  }
+}
+
+#ifdef PIPELINED_MODE
+/*** NMEA ingest task pinned to INGEST_CORE. The serial port is opened here
+ * so the SoftwareSerial interrupts are also handled on this core and a
+ * blocking Nextion command on the other core can't delay the reception.
+*/
+void ingestTask(void *parameter)
+{
+  nmeaSerial.begin(NMEA_BAUD);
+  for (;;)
+  {
+#ifdef ISR_STATS
+    sampleIsrLoad();
+#endif
+    if (ingestStatsReset)
+    {
+      // the counters of this core are only written here
+      ingestStats.busyUs = ingestStats.runs = 0;
+#ifdef WRITE_ENABLED
+      nmeaRelay.resetStats();
+#endif
+      ingestStatsReset = false;
+    }
+    unsigned long start = micros();
+    recvNMEAData();
+    if (nmeaRing.count() > 0)
+    {
+      processNMEAQueue();
+      ingestStats.busyUs += micros() - start;
+      ingestStats.runs++;
+    }
+    // at 4800Bd a 1 tick sleep can't overrun the receive buffer
+    vTaskDelay(1);
+  }
+}
+
+/*** Takes the parsed values from the ingest task into the display variables
+*/
+void receiveValues()
+{
+  NavUpdate update;
+  while (navQueue.pop(update))
+  {
+    if (update.valid)
+    {
+      navState.set(update.key, update.tenths);
+    }
+    else
+    {
+      navState.invalidate(update.key);
     }
+    updateDisplay = true;
   }
 }
 
+/*** Prints the CPU load of both tasks and the queue usage every STATS_INTERVAL.
+ * The counters of the ingest task and the relay are cleared by that task,
+ * a reset from this core could be lost in its read-modify-write.
+*/
+void printStats()
+{
+  unsigned long elapsed = millis() - statsTmr;
+  if (elapsed < STATS_INTERVAL)
+  {
+    return;
+  }
+  statsTmr = millis();
+  elapsed *= 1000; // in us like the busy times
+
+  dbSerial.print("Ingest load%: ");
+  dbSerial.print(100.0 * ingestStats.busyUs / elapsed);
+  dbSerial.print(" runs: ");
+  dbSerial.print(ingestStats.runs);
+  dbSerial.print(" Display load%: ");
+  dbSerial.print(100.0 * displayStats.busyUs / elapsed);
+  dbSerial.print(" frames: ");
+  dbSerial.println(displayStats.runs);
+  dbSerial.print("Queue depth: ");
+  dbSerial.print(navQueue.count());
+  dbSerial.print(" max: ");
+  dbSerial.print(navQueue.highWater());
+  dbSerial.print(" dropped: ");
+  dbSerial.print(navQueue.drops());
+  dbSerial.print(" Ring max: ");
+  dbSerial.print(nmeaRing.highWater());
+  dbSerial.print(" overflows: ");
+  dbSerial.println(nmeaRing.overflows());
+  const HmiFrameStats &frame = hmiFrame.stats();
+  dbSerial.print("HMI frames: ");
+  dbSerial.print(frame.frames);
+  dbSerial.print(" bytes: ");
+  dbSerial.print(frame.bytes);
+  dbSerial.print(" of: ");
+  dbSerial.println(frame.fullBytes);
+  const NexAsyncStats &nex = nexAsyncStats();
+  dbSerial.print("HMI commands: ");
+  dbSerial.print(nex.sent);
+  dbSerial.print(" failed: ");
+  dbSerial.print(nex.failed + nex.timeouts);
+  dbSerial.print(" max in flight: ");
+  dbSerial.println(nex.maxPending);
+  const NexTxStats &tx = nexTxStats();
+  dbSerial.print("HMI bytes: ");
+  dbSerial.print(tx.bytes);
+  dbSerial.print(" writes: ");
+  dbSerial.print(tx.writes);
+  dbSerial.print(" batches: ");
+  dbSerial.println(tx.batches);
+#ifdef WRITE_ENABLED
+  const NmeaRelayStats &relay = nmeaRelay.stats();
+  dbSerial.print("NMEA relayed: ");
+  for (uint8_t i = 0; i < NMEA_RELAY_PRIORITIES; i++)
+  {
+    dbSerial.print(relay.relayed[i]);
+    dbSerial.print(i + 1 < NMEA_RELAY_PRIORITIES ? "/" : " dropped: ");
+  }
+  for (uint8_t i = 0; i < NMEA_RELAY_PRIORITIES; i++)
+  {
+    dbSerial.print(relay.dropped[i]);
+    dbSerial.print(i + 1 < NMEA_RELAY_PRIORITIES ? "/" : " bytes: ");
+  }
+  dbSerial.println(relay.bytes);
+#endif
+
+  ingestStatsReset = true;
+  displayStats.busyUs = displayStats.runs = 0;
+}
+#endif
+
 
 
 void setup()
@@ -476,66 +1023,75 @@ void setup()
 //Serial.begin(115200);
 //Initialize the Nextion Display; the display will run a "selftest" and takes
 // about 15 seconds to finish
+  navState.setNodes(navNodes, sizeof(navNodes) / sizeof(navNodes[0]));
 #ifdef WRITE_ENABLED
-  pinMode(9, OUTPUT);
+  nmeaRelay.setRoutes(nmeaRoutes, sizeof(nmeaRoutes) / sizeof(nmeaRoutes[0]));
 #endif
 
 #ifdef NEXTION_ATTACHED
-  if (nexInit())
-  {
-    dbSerial.println("Initialisation succesful....");
-  }
-  else
-  {
-    dbSerial.println("Initialisation failed...");
-    dbSerial.println("Resetting Nextion...");
-    sendCommand("rest");
-    delay(3000);
-  }
-
-  delay(150);
-  dbSerial.print(" Writing version to splash: ");
-  versionTxt.setText(VERSION);
-  delay(5000);
-  dbSerial.print("Switcing to page 1: ");
-  sendCommand("page 1");
-  recvRetCommandFinished(NEXTION_RCV_DELAY);
-
-  uint32_t displayReady = SELFTEST;
-  delay(2500);
-  // wait until the display status is OK
-  dbSerial.print("Getting HMI status:");
-  while (displayReady < HMI_OK)
-  {
-    dbSerial.print(".");
-    dispStatus.getPic(&displayReady);
-
-    delay(100);
-  }
-  hmiCommtest(45);
-  // restet the HMI o default 0 values
-  memcpy(_AWA, "--.-", 5);
-  memcpy(_COG, "---.-", 6);
-  memcpy(_SOG, "--.-", 5);
-  memcpy(_AWS, "--.-", 5);
-  memcpy(_DPT, "--.-", 5);
-  memcpy(_BAT, "--.-", 5);
-  displayData();
+  // the HMI is started by bootDisplay() from loop(), while the NMEA data
+  // is already received
+  dbSerial.begin(115200);
+  nexSerial.begin(nexLoadBaud() ? nexLoadBaud() : NEX_BAUD);
+  nexSetHandlers(&hmiHandlers);
+  nextBootStep(BOOT_WAIT_READY);
+#else
+  bootStep = BOOT_DONE;
+#endif
+#ifdef TRUEWIND_BENCH
+  benchTrueWind();
 #endif
   //pinMode(10, INPUT_PULLUP);
 
-  nmeaSerial.begin(NMEA_BAUD, SWSERIAL_8N1, NMEA_RX, NMEA_TX, true);
+  selectNmeaInput();
+  nmeaReceiver.setBuffer(nmeaRing.producerSlot());
+#ifdef PIPELINED_MODE
+  xTaskCreatePinnedToCore(ingestTask, "nmeaIngest", INGEST_STACK, NULL,
+                          INGEST_PRIORITY, NULL, INGEST_CORE);
+#else
+  nmeaSerial.begin(NMEA_BAUD);
+#endif
 }
 
 void loop()
 {
+#ifdef PIPELINED_MODE
+  // the Arduino loop runs on core 1 and only builds and sends the frames
+  unsigned long start = micros();
+  nexAsyncPoll();
+#ifdef NEXTION_ATTACHED
+  if (bootStep != BOOT_DONE)
+  {
+    bootDisplay();
+  }
+#endif
+  receiveValues();
+  if (updateDisplay)
+  {
+    displayData();
+    if (!updateDisplay)
+    {
+      displayStats.busyUs += micros() - start;
+      displayStats.runs++;
+    }
+  }
+  printStats();
+#else
   recvNMEAData();
-  if (newData)
+  nexAsyncPoll();
+#ifdef NEXTION_ATTACHED
+  if (bootStep != BOOT_DONE)
+  {
+    bootDisplay();
+  }
+#endif
+  processNMEAQueue();
+  if (updateDisplay)
   {
-    processNMEAData();
     displayData();
   }
-#ifdef WRITE_ENABLED
-  relayData();
+#ifdef ISR_STATS
+  sampleIsrLoad();
+#endif
 #endif
 }
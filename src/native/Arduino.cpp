@@ -0,0 +1,329 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/Arduino.cpp
+  Purpose:  Linux implementation of the Arduino core functions in Arduino.h
+*/
+#ifdef NATIVE_BUILD
+
+#include "Arduino.h"
+#include <time.h>
+#include <unistd.h>
+
+#define VIRTUAL_YIELD_US 10 // time a yield() takes on the virtual clock
+
+static bool virtualClock = false;
+static uint64_t virtualUs = 0;
+
+//*** time since the first call, like the time since boot on the ESP32
+static uint64_t monotonicUs()
+{
+  if (virtualClock)
+  {
+    return virtualUs;
+  }
+  static uint64_t start = 0;
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  uint64_t now = (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+  if (start == 0)
+  {
+    start = now;
+  }
+  return now - start;
+}
+
+unsigned long millis(void)
+{
+  return (unsigned long)(monotonicUs() / 1000);
+}
+
+unsigned long micros(void)
+{
+  return (unsigned long)monotonicUs();
+}
+
+void nativeSetVirtualClock(bool enable)
+{
+  if (enable && !virtualClock)
+  {
+    virtualUs = monotonicUs();
+  }
+  virtualClock = enable;
+}
+
+void nativeAdvanceClock(unsigned long us)
+{
+  virtualUs += us;
+}
+
+void delay(unsigned long ms)
+{
+  if (virtualClock)
+  {
+    virtualUs += (uint64_t)ms * 1000;
+    return;
+  }
+  usleep(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  if (virtualClock)
+  {
+    virtualUs += us;
+    return;
+  }
+  usleep(us);
+}
+
+void yield(void)
+{
+  if (virtualClock)
+  {
+    virtualUs += VIRTUAL_YIELD_US;
+    return;
+  }
+  // give the other end of a pipe or pty some time to produce data
+  usleep(100);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+}
+
+char *ultoa(unsigned long value, char *str, int base)
+{
+  char tmp[8 * sizeof(long) + 1];
+  int i = 0;
+  int j = 0;
+  do
+  {
+    int digit = value % base;
+    tmp[i++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= base;
+  } while (value != 0);
+  while (i > 0)
+  {
+    str[j++] = tmp[--i];
+  }
+  str[j] = '\0';
+  return str;
+}
+
+char *ltoa(long value, char *str, int base)
+{
+  if (value < 0 && base == 10)
+  {
+    str[0] = '-';
+    ultoa((unsigned long)(-value), str + 1, base);
+    return str;
+  }
+  return ultoa((unsigned long)value, str, base);
+}
+
+char *utoa(unsigned int value, char *str, int base)
+{
+  return ultoa(value, str, base);
+}
+
+char *itoa(int value, char *str, int base)
+{
+  return ltoa(value, str, base);
+}
+
+/*** String
+ */
+String::String(const char *cstr) : _buffer(NULL), _len(0)
+{
+  concat(cstr ? cstr : "", cstr ? strlen(cstr) : 0);
+}
+
+String::String(const String &str) : _buffer(NULL), _len(0)
+{
+  concat(str._buffer, str._len);
+}
+
+String::String(char c) : _buffer(NULL), _len(0)
+{
+  concat(&c, 1);
+}
+
+String::String(int value, unsigned char base) : _buffer(NULL), _len(0)
+{
+  char buf[8 * sizeof(long) + 2];
+  ltoa(value, buf, base);
+  concat(buf, strlen(buf));
+}
+
+String::String(unsigned int value, unsigned char base) : _buffer(NULL), _len(0)
+{
+  char buf[8 * sizeof(long) + 2];
+  ultoa(value, buf, base);
+  concat(buf, strlen(buf));
+}
+
+String::String(long value, unsigned char base) : _buffer(NULL), _len(0)
+{
+  char buf[8 * sizeof(long) + 2];
+  ltoa(value, buf, base);
+  concat(buf, strlen(buf));
+}
+
+String::String(unsigned long value, unsigned char base) : _buffer(NULL), _len(0)
+{
+  char buf[8 * sizeof(long) + 2];
+  ultoa(value, buf, base);
+  concat(buf, strlen(buf));
+}
+
+String::String(unsigned char value, unsigned char base) : _buffer(NULL), _len(0)
+{
+  char buf[8 * sizeof(long) + 2];
+  ultoa(value, buf, base);
+  concat(buf, strlen(buf));
+}
+
+String::~String()
+{
+  free(_buffer);
+}
+
+String &String::operator=(const String &rhs)
+{
+  if (this != &rhs)
+  {
+    _len = 0;
+    concat(rhs._buffer, rhs._len);
+  }
+  return *this;
+}
+
+String &String::operator=(const char *cstr)
+{
+  _len = 0;
+  return concat(cstr, strlen(cstr));
+}
+
+String &String::concat(const char *cstr, unsigned int len)
+{
+  char *buffer = (char *)realloc(_buffer, _len + len + 1);
+  if (buffer == NULL)
+  {
+    return *this;
+  }
+  _buffer = buffer;
+  memmove(_buffer + _len, cstr, len);
+  _len += len;
+  _buffer[_len] = '\0';
+  return *this;
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+  if (from >= _len)
+  {
+    return -1;
+  }
+  const char *p = strchr(_buffer + from, c);
+  return p ? (int)(p - _buffer) : -1;
+}
+
+int String::indexOf(const char *str, unsigned int from) const
+{
+  if (from >= _len)
+  {
+    return -1;
+  }
+  const char *p = strstr(_buffer + from, str);
+  return p ? (int)(p - _buffer) : -1;
+}
+
+String operator+(const String &lhs, const String &rhs)
+{
+  String s(lhs);
+  s += rhs;
+  return s;
+}
+
+String operator+(const String &lhs, const char *rhs)
+{
+  String s(lhs);
+  s += rhs;
+  return s;
+}
+
+String operator+(const char *lhs, const String &rhs)
+{
+  String s(lhs);
+  s += rhs;
+  return s;
+}
+
+/*** Print
+ */
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+  while (size--)
+  {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::print(long n, int base)
+{
+  char buf[8 * sizeof(long) + 2];
+  return write(ltoa(n, buf, base));
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+  char buf[8 * sizeof(long) + 2];
+  return write(ultoa(n, buf, base));
+}
+
+size_t Print::print(double n, int digits)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+/*** Stream
+ */
+int Stream::timedRead()
+{
+  unsigned long start = millis();
+  do
+  {
+    if (available() > 0)
+    {
+      return read();
+    }
+    yield();
+  } while (millis() - start < _timeout);
+  return -1;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+  size_t count = 0;
+  while (count < length)
+  {
+    int c = timedRead();
+    if (c < 0)
+    {
+      break;
+    }
+    *buffer++ = (char)c;
+    count++;
+  }
+  return count;
+}
+
+#endif
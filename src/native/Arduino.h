@@ -0,0 +1,139 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/Arduino.h
+  Purpose:  The part of the Arduino core used by this firmware, so it can be
+            build and run on Linux in the native PlatformIO environment.
+
+  NOTES:    Only compiled with NATIVE_BUILD. String, Print and Stream behave
+            like their Arduino counterparts as far as this firmware uses them,
+            String also allocates on the heap like the original does.
+*/
+#ifndef __NATIVE_ARDUINO_H__
+#define __NATIVE_ARDUINO_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PI 3.1415926535897932384626433832795
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define LOW 0x0
+#define HIGH 0x1
+#define INPUT 0x01
+#define OUTPUT 0x02
+#define INPUT_PULLUP 0x05
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+
+/*** Native only: with the virtual clock enabled millis() and micros() only
+ * advance with delay(), yield() and nativeAdvanceClock(), which makes runs
+ * on the host reproducible and independent of the speed of the host.
+ */
+void nativeSetVirtualClock(bool enable);
+void nativeAdvanceClock(unsigned long us);
+
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }
+
+char *utoa(unsigned int value, char *str, int base);
+char *itoa(int value, char *str, int base);
+char *ultoa(unsigned long value, char *str, int base);
+char *ltoa(long value, char *str, int base);
+
+class String
+{
+public:
+  String(const char *cstr = "");
+  String(const String &str);
+  explicit String(char c);
+  explicit String(int value, unsigned char base = DEC);
+  explicit String(unsigned int value, unsigned char base = DEC);
+  explicit String(long value, unsigned char base = DEC);
+  explicit String(unsigned long value, unsigned char base = DEC);
+  explicit String(unsigned char value, unsigned char base = DEC);
+  ~String();
+
+  String &operator=(const String &rhs);
+  String &operator=(const char *cstr);
+  String &operator+=(const String &rhs) { return concat(rhs._buffer, rhs._len); }
+  String &operator+=(const char *cstr) { return concat(cstr, strlen(cstr)); }
+  String &operator+=(char c) { return concat(&c, 1); }
+
+  unsigned int length(void) const { return _len; }
+  const char *c_str() const { return _buffer; }
+  char operator[](unsigned int index) const { return index < _len ? _buffer[index] : 0; }
+  int indexOf(char c, unsigned int from = 0) const;
+  int indexOf(const char *str, unsigned int from = 0) const;
+
+private:
+  String &concat(const char *cstr, unsigned int len);
+
+  char *_buffer;
+  unsigned int _len;
+};
+
+String operator+(const String &lhs, const String &rhs);
+String operator+(const String &lhs, const char *rhs);
+String operator+(const char *lhs, const String &rhs);
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+
+  size_t print(const char str[]) { return write(str); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(const String &s) { return write(s.c_str()); }
+  size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(int n, int base = DEC) { return print((long)n, base); }
+  size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(double n, int digits = 2);
+
+  size_t println(void) { return write("\r\n"); }
+  template <typename T>
+  size_t println(T value) { return print(value) + println(); }
+  template <typename T>
+  size_t println(T value, int format) { return print(value, format) + println(); }
+};
+
+class Stream : public Print
+{
+public:
+  Stream() : _timeout(1000) {}
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual void flush() {}
+
+  void setTimeout(unsigned long timeout) { _timeout = timeout; }
+  size_t readBytes(char *buffer, size_t length);
+  size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+
+protected:
+  int timedRead();
+  unsigned long _timeout;
+};
+
+#endif /* #ifndef __NATIVE_ARDUINO_H__ */
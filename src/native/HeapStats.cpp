@@ -0,0 +1,43 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/HeapStats.cpp
+  Purpose:  Counting replacements of the allocation functions of glibc
+*/
+#ifdef NATIVE_BUILD
+
+#include "HeapStats.h"
+#include <stddef.h>
+
+extern "C"
+{
+  void *__libc_malloc(size_t size);
+  void *__libc_calloc(size_t n, size_t size);
+  void *__libc_realloc(void *ptr, size_t size);
+
+  static volatile uint32_t heapAllocs = 0;
+
+  void *malloc(size_t size)
+  {
+    heapAllocs++;
+    return __libc_malloc(size);
+  }
+
+  void *calloc(size_t n, size_t size)
+  {
+    heapAllocs++;
+    return __libc_calloc(n, size);
+  }
+
+  void *realloc(void *ptr, size_t size)
+  {
+    heapAllocs++;
+    return __libc_realloc(ptr, size);
+  }
+}
+
+uint32_t nativeHeapAllocs()
+{
+  return heapAllocs;
+}
+
+#endif
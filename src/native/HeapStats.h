@@ -0,0 +1,21 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/HeapStats.h
+  Purpose:  Counts the heap allocations of the native build, to check that
+            the frames and the NMEA pipeline don't allocate memory.
+
+  NOTES:    malloc, calloc and realloc of the C library are replaced by
+            counting versions, so String, operator new and the C library
+            itself are all counted. Only the difference between two reads
+            of the counter is meaningful.
+*/
+#ifndef __HEAPSTATS_H__
+#define __HEAPSTATS_H__
+
+#include <stdint.h>
+
+/*** Returns the nr of allocations since the start of the program
+*/
+uint32_t nativeHeapAllocs();
+
+#endif /* #ifndef __HEAPSTATS_H__ */
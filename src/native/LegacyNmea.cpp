@@ -0,0 +1,189 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/LegacyNmea.cpp
+  Purpose:  The NMEA receiver and parser of version 1.35
+*/
+#ifdef NATIVE_BUILD
+
+#include "LegacyNmea.h"
+
+#define NMEA_BUFFER_SIZE 83
+#define FIELD_BUFFER 15
+#define FTM 0.3048
+
+static char _AWA[FIELD_BUFFER] = {0};
+static char _COG[FIELD_BUFFER] = {0};
+static char _SOG[FIELD_BUFFER] = {0};
+static char _AWS[FIELD_BUFFER] = {0};
+static char _BAT[FIELD_BUFFER] = {0};
+static char _DPT[FIELD_BUFFER] = {0};
+static char _DIR[FIELD_BUFFER] = {0};
+
+static char cvalue[FIELD_BUFFER] = {0};
+static unsigned int ci = 0;
+static unsigned int li = 0;
+static uint16_t cp = 0;
+static int field = 0;
+
+static const byte numChars = NMEA_BUFFER_SIZE;
+static char receivedChars[numChars];
+static bool newData = false;
+
+bool legacyRecv(char rc)
+{
+  static bool recvInProgress = false;
+  static byte ndx = 0;
+  char startMarker = '$';
+  char endMarker = '\n';
+
+  newData = false;
+  if (recvInProgress == true)
+  {
+    if (rc != endMarker)
+    {
+      receivedChars[ndx] = rc;
+      ndx++;
+      if (ndx >= numChars)
+      {
+        ndx = numChars - 1;
+      }
+    }
+    else
+    {
+      receivedChars[ndx] = '\0'; // terminate the string
+
+      recvInProgress = false;
+      ndx = 0;
+      newData = true;
+    }
+  }
+  else if (rc == startMarker)
+  {
+    receivedChars[ndx] = rc;
+    ndx++;
+    recvInProgress = true;
+  }
+  return newData;
+}
+
+void legacyProcess()
+{
+  String sentence = "";
+  if (newData == true)
+  {
+    sentence = String(receivedChars);
+
+    ci = sentence.indexOf(',', 0);
+    li = sentence.indexOf(',', ci + 1);
+    cp = 0;
+
+    if (sentence.indexOf("MWV", 0) > 0 ||
+        sentence.indexOf("RMC", 0) > 0 ||
+        sentence.indexOf("DBK", 0) > 0 ||
+        sentence.indexOf("TOB", 0) > 0 ||
+        sentence.indexOf("VWR", 0) > 0 ||
+        sentence.indexOf("BAT", 0) > 0 ||
+        sentence.indexOf("DBT", 0) > 0 ||
+        sentence.indexOf("DPT", 0) > 0)
+    {
+      field = 0; //ignore sentence tag
+      while (li < sentence.length() && li < numChars)
+      {
+        cp = 0;
+        while (ci + 1 < li)
+        {
+          cvalue[cp++] = sentence[ci + 1];
+          ci++;
+        }
+        cvalue[cp] = '\0';
+        field++;
+        // only check for apparent or relative wind directions and speed
+        if ((sentence.indexOf("MWV") > 0 && sentence.indexOf(",R,") > 0) ||
+            sentence.indexOf("VWR") > 0)
+        {
+          if (field == 1)
+          {
+            memcpy(_AWA, cvalue, FIELD_BUFFER - 1);
+          }
+          if (field == 2)
+          {
+            memcpy(_DIR, cvalue, FIELD_BUFFER - 1);
+            if (_DIR[0] == 'L' || _DIR[0] == 'T')
+            {
+              memmove(_AWA + 1, _AWA, FIELD_BUFFER - 2);
+              _AWA[0] = '-';
+            }
+          }
+          if (field == 3)
+          {
+            memcpy(_AWS, cvalue, FIELD_BUFFER - 1);
+          }
+        }
+
+        if (sentence.indexOf("RMC") > 0)
+        {
+          if (field == 7)
+          {
+            memcpy(_SOG, cvalue, FIELD_BUFFER - 1);
+          }
+          if (field == 8)
+          {
+            memcpy(_COG, cvalue, FIELD_BUFFER - 1);
+          }
+        }
+        if (sentence.indexOf("DBK") > 0)
+        {
+          if (field == 2)
+          {
+            memcpy(_DPT, cvalue, FIELD_BUFFER - 1);
+          }
+          if (field == 3 && cvalue[0] == 'f')
+          {
+            double dpt = atof(_DPT);
+            dpt *= FTM;
+            sprintf(_DPT, "%.1f", dpt);
+          }
+        }
+        else if (sentence.indexOf("DBT") > 0)
+        {
+          if (field == 3)
+          {
+            memcpy(_DPT, cvalue, FIELD_BUFFER - 1);
+          }
+        }
+        else if (sentence.indexOf("DPT") > 0)
+        {
+          if (field == 1)
+          {
+            memcpy(_DPT, cvalue, FIELD_BUFFER - 1);
+          }
+        }
+        if (sentence.indexOf("TOB") > 0)
+        {
+          if (field == 1)
+          {
+            memcpy(_BAT, cvalue, FIELD_BUFFER - 1);
+          }
+        }
+        else if (sentence.indexOf("BAT") > 0)
+        {
+          if (field == 2)
+          {
+            memcpy(_BAT, cvalue, FIELD_BUFFER - 1);
+          }
+        }
+        ci = li;
+        li = sentence.indexOf(',', ci + 1);
+        if (li < 0 || li > numChars)
+          li = sentence.length();
+      }
+    }
+  }
+}
+
+const char *legacyAWA()
+{
+  return _AWA;
+}
+
+#endif
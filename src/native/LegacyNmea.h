@@ -0,0 +1,31 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/LegacyNmea.h
+  Purpose:  The NMEA receiver and parser of version 1.35, kept as the
+            baseline of the parser benchmark of the native build.
+
+  NOTES:    Only compiled with NATIVE_BUILD. The code is the original
+            recvNMEAData() and processNMEAData(): a sentence is collected
+            up to <LF> without a checksum check, copied into a String and
+            scanned again with indexOf() for its type and every ','. The
+            values are copied as text into the field buffers like before.
+*/
+#ifndef __LEGACYNMEA_H__
+#define __LEGACYNMEA_H__
+
+#include <Arduino.h>
+
+/*** Feeds one received byte to the legacy receiver
+ * @return true when a sentence is complete
+ */
+bool legacyRecv(char rc);
+
+/*** Parses the complete sentence of the legacy receiver
+ */
+void legacyProcess();
+
+/*** Returns the last AWA as text, to check that the sentences are parsed
+ */
+const char *legacyAWA();
+
+#endif /* #ifndef __LEGACYNMEA_H__ */
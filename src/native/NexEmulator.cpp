@@ -0,0 +1,454 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/NexEmulator.cpp
+  Purpose:  Implementation of the Nextion display emulator
+*/
+#ifdef NATIVE_BUILD
+
+#include "NexEmulator.h"
+#include <ctype.h>
+
+#define LINE_MASK (NEXEMU_LINE_BUFFER - 1)
+
+//*** Nextion return codes
+#define RET_INVALID_CMD 0x00
+#define RET_CMD_FINISHED 0x01
+#define RET_INVALID_COMPONENT 0x02
+#define RET_INVALID_PAGE 0x03
+#define RET_INVALID_BAUD 0x11
+#define RET_INVALID_VARIABLE 0x1A
+#define RET_TOUCH_EVENT 0x65
+#define RET_PAGE_ID 0x66
+#define RET_STRING 0x70
+#define RET_NUMBER 0x71
+#define RET_STARTUP 0x88
+
+NexEmulator::NexEmulator()
+    : _inHead(0), _inTail(0), _outHead(0), _outTail(0), _lineIn(0), _lineOut(0),
+      _cmdLen(0), _ffCount(0), _nrOfAttributes(0), _hostBaud(0), _displayBaud(115200),
+      _savedBaud(115200), _maxBaud(921600), _ackLatency(500), _bkcmd(2), _page(0), _powered(true),
+      _readyAt(0), _bootUs(0)
+{
+  resetStats();
+}
+
+void NexEmulator::resetStats()
+{
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+uint64_t NexEmulator::now()
+{
+  return (uint64_t)micros() * 1000ULL;
+}
+
+void NexEmulator::powerOn(uint32_t bootUs)
+{
+  static const uint8_t startup[] = {0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF,
+                                    RET_STARTUP, 0xFF, 0xFF, 0xFF};
+  _displayBaud = _savedBaud;
+  _bkcmd = 2;
+  _page = 0;
+  _powered = true;
+  _readyAt = now() + (uint64_t)bootUs * 1000ULL;
+  _bootUs = bootUs;
+  _cmdLen = 0;
+  _ffCount = 0;
+  reply(startup, sizeof(startup), now() + (uint64_t)bootUs * 1000ULL);
+}
+
+void NexEmulator::begin(uint32_t baud)
+{
+  _hostBaud = baud;
+}
+
+//*** The attributes of the HMI
+
+NexEmulator::Attribute *NexEmulator::find(const char *name, bool create)
+{
+  for (uint8_t i = 0; i < _nrOfAttributes; i++)
+  {
+    if (strcmp(_attributes[i].name, name) == 0)
+    {
+      return &_attributes[i];
+    }
+  }
+  if (!create || _nrOfAttributes >= NEXEMU_MAX_ATTRIBUTES || strlen(name) >= NEXEMU_NAME_SIZE)
+  {
+    return NULL;
+  }
+  Attribute *a = &_attributes[_nrOfAttributes++];
+  strcpy(a->name, name);
+  a->isString = false;
+  a->number = 0;
+  a->str[0] = '\0';
+  return a;
+}
+
+void NexEmulator::setNumber(const char *name, uint32_t value)
+{
+  Attribute *a = find(name, true);
+  if (a)
+  {
+    a->isString = false;
+    a->number = value;
+  }
+}
+
+void NexEmulator::setString(const char *name, const char *value)
+{
+  Attribute *a = find(name, true);
+  if (a)
+  {
+    a->isString = true;
+    strncpy(a->str, value, NEXEMU_VALUE_SIZE - 1);
+    a->str[NEXEMU_VALUE_SIZE - 1] = '\0';
+  }
+}
+
+bool NexEmulator::getNumber(const char *name, uint32_t *value)
+{
+  Attribute *a = find(name, false);
+  if (a == NULL || a->isString)
+  {
+    return false;
+  }
+  *value = a->number;
+  return true;
+}
+
+const char *NexEmulator::getString(const char *name)
+{
+  Attribute *a = find(name, false);
+  return (a && a->isString) ? a->str : NULL;
+}
+
+//*** Display to host direction
+
+void NexEmulator::reply(const uint8_t *data, size_t len, uint64_t at)
+{
+  if (_hostBaud != _displayBaud)
+  {
+    // garbage on the line, the host UART drops it with framing errors
+    _stats.framingErrors += len;
+    return;
+  }
+  for (size_t i = 0; i < len; i++)
+  {
+    if (_outTail - _outHead >= NEXEMU_LINE_BUFFER)
+    {
+      return; // host doesn't read, like an overrun UART
+    }
+    uint64_t start = at > _lineOut ? at : _lineOut;
+    _lineOut = start + byteNs();
+    _out[_outTail & LINE_MASK].at = _lineOut;
+    _out[_outTail & LINE_MASK].c = data[i];
+    _outTail++;
+  }
+  _stats.bytesOut += len;
+}
+
+void NexEmulator::replyCode(uint8_t code, uint64_t at)
+{
+  uint8_t data[4] = {code, 0xFF, 0xFF, 0xFF};
+  reply(data, sizeof(data), at);
+}
+
+/*** Sends the result of a command as selected with bkcmd:
+ * 0 no replies, 1 only on success, 2 only on failure (default), 3 always
+ */
+void NexEmulator::replyResult(bool ok, uint8_t error, uint64_t at)
+{
+  if (ok && (_bkcmd == 1 || _bkcmd == 3))
+  {
+    _stats.acks++;
+    replyCode(RET_CMD_FINISHED, at);
+  }
+  else if (!ok && (_bkcmd == 2 || _bkcmd == 3))
+  {
+    _stats.errors++;
+    replyCode(error, at);
+  }
+}
+
+void NexEmulator::touch(uint8_t pid, uint8_t cid, bool press)
+{
+  uint8_t data[7] = {RET_TOUCH_EVENT, pid, cid, (uint8_t)(press ? 1 : 0), 0xFF, 0xFF, 0xFF};
+  reply(data, sizeof(data), now());
+}
+
+void NexEmulator::sendFrame(const uint8_t *data, size_t len)
+{
+  reply(data, len, now());
+}
+
+int NexEmulator::available()
+{
+  pump();
+  uint64_t t = now();
+  uint32_t n = 0;
+  while (_outHead + n != _outTail && _out[(_outHead + n) & LINE_MASK].at <= t)
+  {
+    n++;
+  }
+  return n;
+}
+
+int NexEmulator::read()
+{
+  if (available() == 0)
+  {
+    return -1;
+  }
+  return _out[_outHead++ & LINE_MASK].c;
+}
+
+int NexEmulator::peek()
+{
+  if (available() == 0)
+  {
+    return -1;
+  }
+  return _out[_outHead & LINE_MASK].c;
+}
+
+//*** Host to display direction
+
+size_t NexEmulator::write(uint8_t c)
+{
+  uint64_t t = now();
+  uint64_t start = _lineIn > t ? _lineIn : t;
+  uint64_t fifoNs = NEXEMU_TX_FIFO * byteNs();
+
+  // block like a UART driver waiting for room in its TX FIFO
+  if (start - t > fifoNs)
+  {
+    uint32_t waitUs = (uint32_t)((start - t - fifoNs) / 1000ULL);
+    delayMicroseconds(waitUs);
+    _stats.writeBlockedUs += waitUs;
+  }
+  while (_inTail - _inHead >= NEXEMU_LINE_BUFFER)
+  {
+    pump();
+    yield();
+  }
+  _lineIn = start + byteNs();
+  _in[_inTail & LINE_MASK].at = _lineIn;
+  _in[_inTail & LINE_MASK].c = c;
+  _inTail++;
+  return 1;
+}
+
+size_t NexEmulator::write(const uint8_t *buffer, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    write(buffer[i]);
+  }
+  return size;
+}
+
+/*** Processes all bytes which have completely arrived at the display
+*/
+void NexEmulator::pump()
+{
+  uint64_t t = now();
+  while (_inHead != _inTail && _in[_inHead & LINE_MASK].at <= t)
+  {
+    Timed &b = _in[_inHead & LINE_MASK];
+    _inHead++;
+    _stats.bytesIn++;
+    if (b.at < _readyAt)
+    {
+      // still booting
+      continue;
+    }
+    if (_hostBaud != _displayBaud)
+    {
+      // garbage on the line at another baudrate
+      _stats.framingErrors++;
+      _cmdLen = 0;
+      _ffCount = 0;
+      continue;
+    }
+    receive(b.c);
+    if (_ffCount == 3)
+    {
+      _cmd[_cmdLen] = '\0';
+      _cmdLen = 0;
+      _ffCount = 0;
+      uint64_t end = b.at;
+      uint32_t baud = _displayBaud;
+      // replies go out after the processing latency
+      _lineOut = _lineOut > end + (uint64_t)_ackLatency * 1000ULL ? _lineOut : end + (uint64_t)_ackLatency * 1000ULL;
+      execute(_cmd);
+      if (baud != _displayBaud)
+      {
+        // the reply of baud= is sent at the old rate, the line then switches
+        _lineOut = _lineOut > _lineIn ? _lineOut : _lineIn;
+      }
+    }
+  }
+}
+
+void NexEmulator::receive(uint8_t c)
+{
+  if (c == 0xFF)
+  {
+    _ffCount++;
+    return;
+  }
+  if (_ffCount > 0)
+  {
+    // a single 0xFF inside a command, keep it
+    while (_ffCount > 0 && _cmdLen < NEXEMU_MAX_CMD - 1)
+    {
+      _cmd[_cmdLen++] = (char)0xFF;
+      _ffCount--;
+    }
+    _ffCount = 0;
+  }
+  if (_cmdLen < NEXEMU_MAX_CMD - 1)
+  {
+    _cmd[_cmdLen++] = (char)c;
+  }
+}
+
+/*** Executes one command, the reply is scheduled from _lineOut on
+*/
+void NexEmulator::execute(char *cmd)
+{
+  uint64_t at = _lineOut;
+  char *eq;
+
+  if (cmd[0] == '\0')
+  {
+    return; // empty command, sent to clear the input buffer of the display
+  }
+  _stats.commands++;
+
+  if (strncmp(cmd, "get ", 4) == 0)
+  {
+    _stats.gets++;
+    Attribute *a = find(cmd + 4, false);
+    if (strcmp(cmd + 4, "baud") == 0 || strcmp(cmd + 4, "bauds") == 0 || isdigit(cmd[4]))
+    {
+      // a constant is echoed
+      uint32_t number = isdigit(cmd[4]) ? strtoul(cmd + 4, NULL, 10)
+                        : cmd[8] == 's'  ? _savedBaud
+                                         : _displayBaud;
+      uint8_t data[8] = {RET_NUMBER, (uint8_t)number, (uint8_t)(number >> 8),
+                         (uint8_t)(number >> 16), (uint8_t)(number >> 24), 0xFF, 0xFF, 0xFF};
+      reply(data, sizeof(data), at);
+    }
+    else if (a == NULL)
+    {
+      replyResult(false, RET_INVALID_VARIABLE, at);
+    }
+    else if (a->isString)
+    {
+      uint8_t head = RET_STRING;
+      static const uint8_t end[3] = {0xFF, 0xFF, 0xFF};
+      reply(&head, 1, at);
+      reply((const uint8_t *)a->str, strlen(a->str), at);
+      reply(end, 3, at);
+    }
+    else
+    {
+      uint8_t data[8] = {RET_NUMBER, (uint8_t)a->number, (uint8_t)(a->number >> 8),
+                         (uint8_t)(a->number >> 16), (uint8_t)(a->number >> 24), 0xFF, 0xFF, 0xFF};
+      reply(data, sizeof(data), at);
+    }
+    return;
+  }
+  if (strncmp(cmd, "page ", 5) == 0)
+  {
+    _stats.pages++;
+    char *end;
+    unsigned long pid = strtoul(cmd + 5, &end, 10);
+    if (end == cmd + 5 || pid > 255)
+    {
+      replyResult(false, RET_INVALID_PAGE, at);
+      return;
+    }
+    _page = (uint8_t)pid;
+    replyResult(true, 0, at);
+    return;
+  }
+  if (strcmp(cmd, "sendme") == 0)
+  {
+    uint8_t data[5] = {RET_PAGE_ID, _page, 0xFF, 0xFF, 0xFF};
+    reply(data, sizeof(data), at);
+    return;
+  }
+  if (strncmp(cmd, "ref ", 4) == 0)
+  {
+    _stats.refs++;
+    replyResult(true, 0, at);
+    return;
+  }
+  if (strcmp(cmd, "rest") == 0)
+  {
+    powerOn(_bootUs);
+    return;
+  }
+  if (strncmp(cmd, "bkcmd=", 6) == 0)
+  {
+    _bkcmd = (uint8_t)atoi(cmd + 6);
+    replyResult(true, 0, at);
+    return;
+  }
+  if (strncmp(cmd, "baud=", 5) == 0 || strncmp(cmd, "bauds=", 6) == 0)
+  {
+    unsigned long baud = strtoul(strchr(cmd, '=') + 1, NULL, 10);
+    if (baud < 2400 || baud > _maxBaud)
+    {
+      replyResult(false, RET_INVALID_BAUD, at);
+      return;
+    }
+    replyResult(true, 0, at);
+    if (cmd[4] == 's')
+    {
+      _savedBaud = baud;
+    }
+    _displayBaud = baud;
+    return;
+  }
+
+  eq = strchr(cmd, '=');
+  if (eq != NULL && eq != cmd)
+  {
+    // <component>.<attribute>=<value> or a system variable like dim=
+    _stats.assignments++;
+    *eq = '\0';
+    const char *value = eq + 1;
+    size_t len = strlen(value);
+    if (len >= 2 && value[0] == '"' && value[len - 1] == '"')
+    {
+      char str[NEXEMU_VALUE_SIZE];
+      len = len - 2 < NEXEMU_VALUE_SIZE - 1 ? len - 2 : NEXEMU_VALUE_SIZE - 1;
+      memcpy(str, value + 1, len);
+      str[len] = '\0';
+      setString(cmd, str);
+    }
+    else
+    {
+      char *end;
+      uint32_t number = strtoul(value, &end, 10);
+      if (end == value)
+      {
+        replyResult(false, RET_INVALID_VARIABLE, at);
+        return;
+      }
+      setNumber(cmd, number);
+    }
+    replyResult(true, 0, at);
+    return;
+  }
+
+  // ref_stop, ref_star, click, add, vis, dim... are accepted as is
+  _stats.unknown++;
+  replyResult(true, 0, at);
+}
+
+#endif
@@ -0,0 +1,161 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/NexEmulator.h
+  Purpose:  Emulates a Nextion display on Linux so the Nex* classes and the
+            frames of the wind display can be benchmarked without the
+            NX8048P070 panel.
+
+  NOTES:    The emulator is a SerialTransport, so it can be set as
+            nexTransport directly, or served on a pty by the native main for
+            other processes. It speaks the Nextion serial protocol:
+            - commands terminated with 0xFF 0xFF 0xFF
+            - 0x01 and error replies depending on bkcmd (default 2)
+            - 0x70 string and 0x71 number replies on "get"
+            - 0x65 touch and 0x66 page events, 0x88 ready after power on
+            It keeps the attributes written per component and answers gets
+            from them.
+            Both directions of the line are paced at the baudrate: a byte
+            arrives 10 bit times after the previous one, and write() blocks
+            like a UART with a full TX FIFO. Replies are sent ackLatency us
+            after the command is received. All timing is based on micros(),
+            so with the virtual clock of the native build it is
+            reproducible.
+            The emulator doesn't allocate memory, so it doesn't disturb the
+            heap statistics of the firmware.
+*/
+#ifndef __NEXEMULATOR_H__
+#define __NEXEMULATOR_H__
+
+#include "SerialTransport.h"
+
+#define NEXEMU_MAX_CMD 256      // longest command accepted
+#define NEXEMU_MAX_ATTRIBUTES 64 // nr of component attributes kept
+#define NEXEMU_NAME_SIZE 32     // "<page>.<component>.<attribute>" incl. '\0'
+#define NEXEMU_VALUE_SIZE 256   // longest string attribute incl. '\0'
+#define NEXEMU_LINE_BUFFER 4096 // bytes in transit per direction, power of 2
+#define NEXEMU_TX_FIFO 128      // bytes the host UART accepts without blocking
+
+/*** Counters of the emulator, per command kind
+*/
+struct NexEmulatorStats
+{
+  uint32_t commands;    // all terminated commands
+  uint32_t assignments; // <name>.<attr>=<value>
+  uint32_t gets;        // get <name>.<attr>
+  uint32_t refs;        // ref <name> redraws
+  uint32_t pages;       // page changes
+  uint32_t acks;        // 0x01 replies
+  uint32_t errors;      // error replies
+  uint32_t unknown;     // commands acknowledged without emulating them
+  uint32_t framingErrors; // bytes lost due to a baudrate mismatch
+  uint32_t bytesIn;     // bytes received from the host
+  uint32_t bytesOut;    // bytes sent to the host
+  uint32_t writeBlockedUs; // time the host was blocked writing
+};
+
+class NexEmulator : public SerialTransport
+{
+public:
+  NexEmulator();
+
+  /*** Time between the end of a command and the start of its reply
+   */
+  void setAckLatency(uint32_t us) { _ackLatency = us; }
+  uint32_t ackLatency() const { return _ackLatency; }
+
+  /*** Baudrate of the display, 115200 like the wind display HMI is set up
+   */
+  void setDisplayBaud(uint32_t baud) { _displayBaud = baud; }
+  uint32_t displayBaud() const { return _displayBaud; }
+
+  /*** Highest baudrate accepted with baud= and bauds=, 921600 by default
+   */
+  void setMaxBaud(uint32_t baud) { _maxBaud = baud; }
+
+  /*** Switches the display on, the 0x88 ready event is sent after bootUs.
+   * Until then the display ignores what it receives. A rest takes as
+   * long as the last power on.
+   */
+  void powerOn(uint32_t bootUs);
+
+  /*** Presets an attribute like the HMI code would, i.e. "status.pic"
+   */
+  void setNumber(const char *name, uint32_t value);
+  void setString(const char *name, const char *value);
+  bool getNumber(const char *name, uint32_t *value);
+  const char *getString(const char *name);
+
+  /*** Emulates a push (press true) or pop touch event on component pid/cid
+   */
+  void touch(uint8_t pid, uint8_t cid, bool press);
+
+  /*** Sends a frame the display sends by itself, i.e. a sleep event or the
+   * output of print, the 0xFF 0xFF 0xFF terminator included
+   */
+  void sendFrame(const uint8_t *data, size_t len);
+
+  uint8_t page() const { return _page; }
+  const NexEmulatorStats &stats() const { return _stats; }
+  void resetStats();
+
+  // SerialTransport, the host side of the line
+  void begin(uint32_t baud);
+  uint32_t baudRate() { return _hostBaud; }
+  int available();
+  int read();
+  int peek();
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buffer, size_t size);
+
+private:
+  struct Timed
+  {
+    uint64_t at; // ns at which the byte is completely on the other side
+    uint8_t c;
+  };
+
+  struct Attribute
+  {
+    char name[NEXEMU_NAME_SIZE];
+    bool isString;
+    uint32_t number;
+    char str[NEXEMU_VALUE_SIZE];
+  };
+
+  uint64_t byteNs() const { return 10000000000ULL / _displayBaud; }
+  uint64_t now();
+  void pump();
+  void receive(uint8_t c);
+  void execute(char *cmd);
+  void reply(const uint8_t *data, size_t len, uint64_t at);
+  void replyCode(uint8_t code, uint64_t at);
+  void replyResult(bool ok, uint8_t error, uint64_t at);
+  Attribute *find(const char *name, bool create);
+
+  Timed _in[NEXEMU_LINE_BUFFER];
+  Timed _out[NEXEMU_LINE_BUFFER];
+  uint32_t _inHead, _inTail, _outHead, _outTail;
+  uint64_t _lineIn;  // ns at which the host to display line is free
+  uint64_t _lineOut; // ns at which the display to host line is free
+
+  char _cmd[NEXEMU_MAX_CMD];
+  uint16_t _cmdLen;
+  uint8_t _ffCount;
+
+  Attribute _attributes[NEXEMU_MAX_ATTRIBUTES];
+  uint8_t _nrOfAttributes;
+
+  uint32_t _hostBaud;
+  uint32_t _displayBaud;
+  uint32_t _savedBaud; // set with bauds=, used at the next power on
+  uint32_t _maxBaud;
+  uint32_t _ackLatency;
+  uint8_t _bkcmd;
+  uint8_t _page;
+  bool _powered;
+  uint64_t _readyAt; // ns from which the display executes commands
+  uint32_t _bootUs;
+  NexEmulatorStats _stats;
+};
+
+#endif /* #ifndef __NEXEMULATOR_H__ */
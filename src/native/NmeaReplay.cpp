@@ -0,0 +1,198 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/NmeaReplay.cpp
+  Purpose:  Implementation of the NMEA log replay
+*/
+#ifdef NATIVE_BUILD
+
+#include "NmeaReplay.h"
+
+#define RX_MASK (REPLAY_RX_SIZE - 1)
+
+NmeaReplay::NmeaReplay()
+    : _file(NULL), _rate(1.0), _baud(4800), _rxCapacity(REPLAY_RX_CAPACITY),
+      _lineLen(0), _linePos(0), _lineLost(false), _nextNs(0), _started(false),
+      _firstStamp(-1.0), _startNs(0), _lastFillUs(0), _head(0), _tail(0)
+{
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+NmeaReplay::~NmeaReplay()
+{
+  if (_file)
+  {
+    fclose(_file);
+  }
+}
+
+bool NmeaReplay::open(const char *path)
+{
+  _file = fopen(path, "r");
+  if (_file)
+  {
+    // no heap buffer, so the replay doesn't show up in the heap statistics
+    setvbuf(_file, _fileBuffer, _IOFBF, sizeof(_fileBuffer));
+  }
+  return _file != NULL;
+}
+
+void NmeaReplay::setRxCapacity(size_t bytes)
+{
+  _rxCapacity = bytes < REPLAY_RX_SIZE ? bytes : REPLAY_RX_SIZE;
+}
+
+uint64_t NmeaReplay::byteNs() const
+{
+  double ns = 10e9 / _baud;
+  return (uint64_t)(_rate > 0 ? ns / _rate : 0);
+}
+
+/*** Reads the next sentence of the log and sets the time it starts to arrive
+*/
+bool NmeaReplay::nextLine()
+{
+  char raw[REPLAY_LINE_SIZE];
+  uint64_t nowNs = (uint64_t)micros() * 1000ULL;
+
+  if (!_started)
+  {
+    _started = true;
+    _startNs = nowNs;
+    _nextNs = nowNs;
+  }
+  while (_file && fgets(raw, sizeof(raw), _file))
+  {
+    char *p = raw;
+    double stamp = -1.0;
+
+    if (isDigit(*p))
+    {
+      stamp = strtod(p, &p);
+      if (stamp > 1e11)
+      {
+        stamp /= 1000.0; // ms
+      }
+      while (*p == ' ' || *p == '\t' || *p == ',' || *p == ';')
+      {
+        p++;
+      }
+    }
+    if (*p != '$' && *p != '!')
+    {
+      continue; // empty line or comment
+    }
+    size_t len = strcspn(p, "\r\n");
+    if (len > REPLAY_LINE_SIZE - 3)
+    {
+      len = REPLAY_LINE_SIZE - 3;
+    }
+    memcpy(_line, p, len);
+    _line[len++] = '\r';
+    _line[len++] = '\n';
+    _lineLen = len;
+    _linePos = 0;
+    _lineLost = false;
+    _stats.lines++;
+
+    if (stamp >= 0 && _rate > 0)
+    {
+      if (_firstStamp < 0)
+      {
+        _firstStamp = stamp;
+      }
+      uint64_t due = _startNs + (uint64_t)((stamp - _firstStamp) * 1e9 / _rate);
+      if (due > _nextNs)
+      {
+        _nextNs = due;
+      }
+    }
+    return true;
+  }
+  if (_file)
+  {
+    fclose(_file);
+    _file = NULL;
+  }
+  return false;
+}
+
+/*** Moves all bytes which have arrived by now into the receive buffer
+*/
+void NmeaReplay::pump()
+{
+  uint64_t nowNs = (uint64_t)micros() * 1000ULL;
+
+  if (_rate <= 0)
+  {
+    if (micros() == _lastFillUs && _started)
+    {
+      return;
+    }
+    _lastFillUs = micros();
+  }
+  for (;;)
+  {
+    if (_linePos >= _lineLen && !nextLine())
+    {
+      return;
+    }
+    if (_rate > 0)
+    {
+      if (_nextNs > nowNs)
+      {
+        return;
+      }
+      _nextNs += byteNs();
+    }
+    else if (_tail - _head >= _rxCapacity)
+    {
+      return; // as fast as possible, but wait for the firmware to read
+    }
+
+    uint8_t c = _line[_linePos++];
+    _stats.bytes++;
+    if (_tail - _head >= _rxCapacity)
+    {
+      _stats.bytesLost++;
+      if (!_lineLost)
+      {
+        _lineLost = true;
+        _stats.linesHit++;
+      }
+      continue;
+    }
+    _rx[_tail++ & RX_MASK] = c;
+  }
+}
+
+int NmeaReplay::available()
+{
+  pump();
+  return (int)(_tail - _head);
+}
+
+int NmeaReplay::read()
+{
+  if (available() == 0)
+  {
+    return -1;
+  }
+  return _rx[_head++ & RX_MASK];
+}
+
+int NmeaReplay::peek()
+{
+  if (available() == 0)
+  {
+    return -1;
+  }
+  return _rx[_head & RX_MASK];
+}
+
+bool NmeaReplay::eof()
+{
+  pump();
+  return _file == NULL && _linePos >= _lineLen && _head == _tail;
+}
+
+#endif
@@ -0,0 +1,94 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/NmeaReplay.h
+  Purpose:  Replays a recorded NMEA log as NMEA input of the firmware, at the
+            speed it was recorded, time accelerated or as fast as possible.
+
+  NOTES:    The log is read line by line while replaying, so logs of any
+            length can be used. Two formats are accepted, also mixed:
+            - raw:         $IIMWV,034,R,12.3,N,A*14
+            - timestamped: 1617184800.250 $IIMWV,034,R,12.3,N,A*14
+              the timestamp is in seconds, or in ms if it is larger than 1e11
+            Lines of a raw log follow each other at the NMEA baudrate, a
+            timestamped line is not sent before its timestamp.
+            Bytes arrive at the baudrate multiplied by the rate in the
+            receive buffer of the input, which has the capacity of the
+            SoftwareSerial buffer. Bytes arriving in a full buffer are lost,
+            like on the real device. With rate 0 the buffer is filled up
+            every time the clock advanced, so the log is fed as fast as the
+            firmware reads it and nothing is lost.
+            Use it with the virtual clock to get reproducible results.
+*/
+#ifndef __NMEAREPLAY_H__
+#define __NMEAREPLAY_H__
+
+#include <stdio.h>
+#include "SerialTransport.h"
+
+#define REPLAY_LINE_SIZE 256
+#define REPLAY_RX_CAPACITY 64 // default buffer of EspSoftwareSerial
+#define REPLAY_RX_SIZE 1024   // max buffer capacity, power of 2
+#define REPLAY_FILE_BUFFER 4096
+
+struct NmeaReplayStats
+{
+  uint32_t lines;     // sentences read from the log
+  uint32_t bytes;     // bytes offered to the firmware
+  uint32_t bytesLost; // bytes lost in a full receive buffer
+  uint32_t linesHit;  // sentences which lost at least one byte
+};
+
+class NmeaReplay : public SerialTransport
+{
+public:
+  NmeaReplay();
+  ~NmeaReplay();
+
+  bool open(const char *path);
+
+  /*** Replay speed, 1.0 is real time, 10.0 ten times faster and 0 as fast
+   * as the firmware reads
+   */
+  void setRate(double rate) { _rate = rate; }
+  void setRxCapacity(size_t bytes);
+
+  void begin(uint32_t baud) { _baud = baud; }
+  uint32_t baudRate() { return _baud; }
+  int available();
+  int read();
+  int peek();
+  size_t write(uint8_t c) { return 1; } // relayed data goes nowhere
+
+  /*** Returns true if the complete log has been read by the firmware
+   */
+  bool eof();
+  const NmeaReplayStats &stats() const { return _stats; }
+
+private:
+  bool nextLine();
+  void pump();
+  uint64_t byteNs() const;
+
+  FILE *_file;
+  char _fileBuffer[REPLAY_FILE_BUFFER];
+  double _rate;
+  uint32_t _baud;
+  size_t _rxCapacity;
+
+  char _line[REPLAY_LINE_SIZE];
+  size_t _lineLen;
+  size_t _linePos;
+  bool _lineLost;
+  uint64_t _nextNs;    // arrival time of the next byte
+  bool _started;
+  double _firstStamp;  // timestamp of the first timestamped line
+  uint64_t _startNs;   // clock at the first line
+  unsigned long _lastFillUs; // clock at the last fill with rate 0
+
+  uint8_t _rx[REPLAY_RX_SIZE];
+  size_t _head;
+  size_t _tail;
+  NmeaReplayStats _stats;
+};
+
+#endif /* #ifndef __NMEAREPLAY_H__ */
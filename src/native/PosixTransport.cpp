@@ -0,0 +1,168 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/PosixTransport.cpp
+  Purpose:  Implementation of the Linux serial transport
+*/
+#ifdef NATIVE_BUILD
+
+#include "PosixTransport.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+PosixTransport::PosixTransport(int rxFd, int txFd)
+    : _rxFd(rxFd), _txFd(txFd), _baud(0), _eof(false), _head(0), _tail(0)
+{
+}
+
+bool PosixTransport::open(const char *path)
+{
+  struct stat st;
+  int fd;
+
+  if (stat(path, &st) == 0 && S_ISREG(st.st_mode))
+  {
+    fd = ::open(path, O_RDONLY);
+    _txFd = -1;
+  }
+  else
+  {
+    fd = ::open(path, O_RDWR | O_NOCTTY);
+    _txFd = fd;
+  }
+  _rxFd = fd;
+  _eof = false;
+  _head = _tail = 0;
+  return fd >= 0;
+}
+
+//*** maps a baudrate on the termios speed constant, B0 if not supported
+static speed_t termiosSpeed(uint32_t baud)
+{
+  switch (baud)
+  {
+  case 4800:
+    return B4800;
+  case 9600:
+    return B9600;
+  case 19200:
+    return B19200;
+  case 38400:
+    return B38400;
+  case 57600:
+    return B57600;
+  case 115200:
+    return B115200;
+  case 230400:
+    return B230400;
+  case 460800:
+    return B460800;
+  case 921600:
+    return B921600;
+  default:
+    return B0;
+  }
+}
+
+void PosixTransport::begin(uint32_t baud)
+{
+  struct termios tio;
+
+  _baud = baud;
+  if (_rxFd >= 0 && isatty(_rxFd) && tcgetattr(_rxFd, &tio) == 0)
+  {
+    cfmakeraw(&tio);
+    if (termiosSpeed(baud) != B0)
+    {
+      cfsetispeed(&tio, termiosSpeed(baud));
+      cfsetospeed(&tio, termiosSpeed(baud));
+    }
+    tcsetattr(_rxFd, TCSANOW, &tio);
+  }
+  if (_rxFd >= 0)
+  {
+    fcntl(_rxFd, F_SETFL, fcntl(_rxFd, F_GETFL) | O_NONBLOCK);
+  }
+}
+
+/*** Reads whatever the descriptor has available without blocking
+*/
+void PosixTransport::fill()
+{
+  if (_rxFd < 0 || _eof)
+  {
+    return;
+  }
+  if (_head == _tail)
+  {
+    _head = _tail = 0;
+  }
+  if (_tail >= sizeof(_rx))
+  {
+    return;
+  }
+  ssize_t n = ::read(_rxFd, _rx + _tail, sizeof(_rx) - _tail);
+  if (n > 0)
+  {
+    _tail += n;
+  }
+  else if (n == 0 && !isatty(_rxFd))
+  {
+    // end of a file or the writer closed the pipe
+    _eof = true;
+  }
+}
+
+int PosixTransport::available()
+{
+  if (_head == _tail)
+  {
+    fill();
+  }
+  return (int)(_tail - _head);
+}
+
+int PosixTransport::read()
+{
+  if (available() == 0)
+  {
+    return -1;
+  }
+  return _rx[_head++];
+}
+
+int PosixTransport::peek()
+{
+  if (available() == 0)
+  {
+    return -1;
+  }
+  return _rx[_head];
+}
+
+size_t PosixTransport::write(const uint8_t *buffer, size_t size)
+{
+  size_t done = 0;
+  if (_txFd < 0)
+  {
+    return size; // nothing connected, behave like an open line
+  }
+  while (done < size)
+  {
+    ssize_t n = ::write(_txFd, buffer + done, size - done);
+    if (n < 0)
+    {
+      if (errno == EAGAIN || errno == EINTR)
+      {
+        continue;
+      }
+      break;
+    }
+    done += n;
+  }
+  return done;
+}
+
+#endif
@@ -0,0 +1,52 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/PosixTransport.h
+  Purpose:  Linux serial transport on top of file descriptors, so a recorded
+            log file, a pipe, a pty or a real serial device can be used as
+            NMEA input or as link to the Nextion display.
+*/
+#ifndef __POSIXTRANSPORT_H__
+#define __POSIXTRANSPORT_H__
+
+#include "SerialTransport.h"
+
+#define POSIX_RX_BUFFER 512
+
+class PosixTransport : public SerialTransport
+{
+public:
+  /*** Uses already opened descriptors, -1 if a direction is not used
+   */
+  PosixTransport(int rxFd, int txFd);
+
+  /*** Opens path for reading and writing (or only reading for a regular file)
+   * @return false if the path can't be opened
+   */
+  bool open(const char *path);
+
+  void begin(uint32_t baud);
+  uint32_t baudRate() { return _baud; }
+
+  int available();
+  int read();
+  int peek();
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t write(const uint8_t *buffer, size_t size);
+
+  /*** Returns true if the input reached its end, i.e. the end of a log file
+   */
+  bool eof() { return _eof && _head == _tail; }
+
+private:
+  void fill();
+
+  int _rxFd;
+  int _txFd;
+  uint32_t _baud;
+  bool _eof;
+  uint8_t _rx[POSIX_RX_BUFFER];
+  size_t _head;
+  size_t _tail;
+};
+
+#endif /* #ifndef __POSIXTRANSPORT_H__ */
@@ -0,0 +1,44 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/TrueWindRef.h
+  Purpose:  The true wind in floating point, the reference of the fixed-point
+            kernel for its unit tests and benchmarks.
+
+  NOTES:    Used with NATIVE_BUILD, and by the firmware with TRUEWIND_BENCH
+            to time the kernel on the ESP32. Both fill tw with TWS, TWA,
+            TWD and VMG in knots and degrees from the inputs of
+            twCalculate(), which are in tenths.
+*/
+#ifndef __TRUEWINDREF_H__
+#define __TRUEWINDREF_H__
+
+#include <Arduino.h>
+#include <math.h>
+
+/*** The true wind in double precision, TWS, TWA, TWD and VMG
+*/
+static inline void trueWindDouble(int32_t aws, int32_t awa, int32_t sog, int32_t cog, double *tw)
+{
+  double a = awa / 10.0 * PI / 180;
+  double x = aws / 10.0 * cos(a) - sog / 10.0;
+  double y = aws / 10.0 * sin(a);
+  tw[0] = sqrt(x * x + y * y);
+  tw[1] = atan2(y, x) * 180 / PI;
+  tw[2] = fmod(cog / 10.0 + tw[1] + 360, 360);
+  tw[3] = sog / 10.0 * cos(tw[1] * PI / 180);
+}
+
+/*** The true wind in single precision like it was calculated before
+*/
+static inline void trueWindFloat(int32_t aws, int32_t awa, int32_t sog, int32_t cog, float *tw)
+{
+  float a = awa / 10.0f * (float)PI / 180;
+  float x = aws / 10.0f * cosf(a) - sog / 10.0f;
+  float y = aws / 10.0f * sinf(a);
+  tw[0] = sqrtf(x * x + y * y);
+  tw[1] = atan2f(y, x) * 180 / (float)PI;
+  tw[2] = fmodf(cog / 10.0f + tw[1] + 360, 360);
+  tw[3] = sog / 10.0f * cosf(tw[1] * (float)PI / 180);
+}
+
+#endif /* #ifndef __TRUEWINDREF_H__ */
@@ -0,0 +1,795 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     native/main_native.cpp
+  Purpose:  Runs the firmware on Linux.
+
+  Usage:    program [options] <nmea input>
+            -n <device>  use a Nextion on a pty or serial device instead of
+                         the built-in emulator
+            -l <us>      ack latency of the emulator, default 500us
+            -B <baud>    baudrate negotiated by the -b benchmark
+            -M <baud>    highest baudrate the emulator accepts
+            -b <count>   benchmark <count> setText round trips against the
+                         emulator and exit
+            -s <count>   benchmark <count> theme changes against the emulator,
+                         plain, in redraw transactions and with the shadow
+                         cache, and exit
+            -e <count>   benchmark <count> events of all kinds sent by the
+                         emulator through nexLoop and exit
+            -i <count>   benchmark <count> touch events dispatched to 48
+                         components, indexed and walked, and exit
+            -w <count>   benchmark <count> calculations of the true wind
+                         kernel, float and double, and exit
+            -P <passes>  parse the NMEA log file <passes> times with the
+                         String/indexOf parser of version 1.35 and with the
+                         streaming receiver, print both rates and exit
+            -p           serve the emulator on a pty for other processes
+            -r <rate>    replay speed of a log file, 1 real time (default),
+                         10 ten times faster, 0 as fast as possible
+            -c <bytes>   receive buffer of the NMEA input, default 64
+            -t <us>      time a loop() takes on the virtual clock, default 100
+            -o <ms>      power the emulator on when a log file is replayed,
+                         it is ready after <ms> and its selftest takes
+                         EMULATOR_SELFTEST ms more; default it is running
+            -R <bytes/s> rate of the NMEA relay when built with
+                         -DWRITE_ENABLED, default the 480 bytes/s of 4800 Bd
+            The NMEA input is a log file, a fifo or a serial device. A log
+            file is replayed on a virtual clock, see NmeaReplay.h, and a
+            report of the throughput is printed at the end. The program ends
+            when the NMEA input reaches its end. test/data/test.nmea is a
+            log of wind, RMC, depth and battery sentences.
+            The unit tests in test/ are run with: pio test -e native
+*/
+#ifdef NATIVE_BUILD
+
+#include <Arduino.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <Nextion.h>
+#include "PosixTransport.h"
+#include "NexEmulator.h"
+#include "HmiFrame.h"
+#include "TrueWind.h"
+#include "TrueWindRef.h"
+#include "HeapStats.h"
+#include "NmeaParser.h"
+#include "NmeaReplay.h"
+#include "NmeaRing.h"
+#include "NmeaRelay.h"
+#include "LegacyNmea.h"
+#include <sys/stat.h>
+#include <time.h>
+
+#define EMULATOR_SELFTEST_PIC 3 // status picture during the selftest of the HMI
+#define EMULATOR_HMI_OK 4 // status picture set by the HMI after its selftest
+#define EMULATOR_SELFTEST 1500 // ms the selftest of the HMI takes
+#define REPLAY_BOOT_TIMEOUT 60000 // ms of virtual time a replay waits for the first frame
+
+void setup();
+void loop();
+void processNMEAData(const NmeaSentence &sentence);
+extern unsigned long firstFrameMs;
+extern SerialTransport *nmeaTransport;
+extern NmeaReceiver nmeaReceiver;
+extern NmeaRing nmeaRing;
+#ifdef WRITE_ENABLED
+extern NmeaRelay nmeaRelay;
+#endif
+extern HmiFrame hmiFrame;
+extern NavState navState;
+
+PosixTransport debugOut(-1, STDOUT_FILENO);
+PosixTransport nowhere(-1, -1);
+PosixTransport nextionLink(-1, -1);
+PosixTransport nmeaInput(-1, -1);
+NmeaReplay nmeaReplay;
+NexEmulator emulator;
+
+SerialTransport *dbTransport = &debugOut;
+SerialTransport *nexTransport = &emulator;
+
+//*** the stored baudrate of the display link, kept for one run only
+static uint32_t storedBaud = 0;
+
+uint32_t nexLoadBaud() { return storedBaud; }
+void nexSaveBaud(uint32_t baud) { storedBaud = baud; }
+
+static void printEmulatorStats()
+{
+  const NexEmulatorStats &s = emulator.stats();
+  printf("Emulator: commands %u assignments %u gets %u refs %u pages %u unknown %u\n",
+         s.commands, s.assignments, s.gets, s.refs, s.pages, s.unknown);
+  printf("          acks %u errors %u framing errors %u bytes in %u out %u blocked %uus\n",
+         s.acks, s.errors, s.framingErrors, s.bytesIn, s.bytesOut, s.writeBlockedUs);
+}
+
+/*** Measures the round trip of the frame update of the wind display
+*/
+static int benchNextion(uint32_t count, uint32_t baud)
+{
+  static const char frame[] = "COG=213.2#AWA=-37#SOG=6.4#AWS=15.7#BAT=12.5#DPT=3.4#TWS=12.1#";
+  NexText nmeaTxt(1, 16, "nmea");
+  uint32_t minUs = 0xFFFFFFFF;
+  uint32_t maxUs = 0;
+  uint64_t totalUs = 0;
+  uint32_t failed = 0;
+
+  dbTransport = &nowhere; // debug output would be part of the measurement
+  nexInit(baud);
+  emulator.resetStats();
+  uint32_t startAllocs = nativeHeapAllocs();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    unsigned long start = micros();
+    if (!nmeaTxt.setText(frame))
+    {
+      failed++;
+    }
+    uint32_t us = micros() - start;
+    totalUs += us;
+    minUs = us < minUs ? us : minUs;
+    maxUs = us > maxUs ? us : maxUs;
+  }
+  printf("setText round trip of %u bytes at %u Bd, ack latency %uus: %u x\n",
+         (unsigned)strlen(frame), nexTransport->baudRate(), emulator.ackLatency(), count);
+  printf("  avg %lluus min %uus max %uus failed %u => %.1f frames/s\n",
+         (unsigned long long)(totalUs / count), minUs, maxUs, failed,
+         count * 1000000.0 / totalUs);
+  printf("  heap allocations %.1f per setText\n", (double)(nativeHeapAllocs() - startAllocs) / count);
+  printEmulatorStats();
+  return failed ? 1 : 0;
+}
+
+/*** Applies a theme, alternating day and night, to a page of numbers count
+ * times and reads the values back
+*/
+static uint32_t benchTheme(NexNumber *numbers[], uint8_t nr, uint32_t count, bool transaction)
+{
+  emulator.resetStats();
+  unsigned long start = micros();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    if (transaction)
+    {
+      NexObject::beginRedraw();
+    }
+    for (uint8_t n = 0; n < nr; n++)
+    {
+      uint32_t value;
+      numbers[n]->Set_background_color_bco(i & 1 ? 0 : 65535);
+      numbers[n]->Set_font_color_pco(i & 1 ? 63488 : 0);
+      numbers[n]->setValue(n * 10);
+      numbers[n]->getValue(&value);
+    }
+    if (transaction)
+    {
+      NexObject::commitRedraw();
+    }
+  }
+  uint32_t us = micros() - start;
+  // let the emulator execute the last commands before reading its stats
+  delay(20);
+  while (emulator.available() > 0)
+  {
+    emulator.read();
+  }
+  return us;
+}
+
+static void printTheme(const char *name, uint32_t us, uint32_t count)
+{
+  const NexEmulatorStats &stats = emulator.stats();
+  printf("  %-8s %8uus, %5u commands, %5u refs, %.1f refs per theme\n", name, us,
+         stats.commands, stats.refs, (double)stats.refs / count);
+}
+
+static int benchThemes(uint32_t count)
+{
+  static NexShadowEntry entries[4][3];
+  NexNumber n0(1, 2, "n0"), n1(1, 3, "n1"), n2(1, 4, "n2"), n3(1, 5, "n3");
+  NexNumber *numbers[] = {&n0, &n1, &n2, &n3};
+
+  dbTransport = &nowhere;
+  nexInit();
+  printf("theme of 4 numbers, 3 sets and 1 get each, %u x, ack latency %uus\n",
+         count, emulator.ackLatency());
+  printTheme("plain:", benchTheme(numbers, 4, count, false), count);
+  printTheme("redraw:", benchTheme(numbers, 4, count, true), count);
+  for (uint8_t n = 0; n < 4; n++)
+  {
+    numbers[n]->attachShadow(entries[n], 3);
+  }
+  printTheme("shadow:", benchTheme(numbers, 4, count, true), count);
+  const NexShadowStats &shadow = NexObject::shadowStats();
+  const NexRedrawStats &redraw = NexObject::redrawStats();
+  printf("  shadow cache: %u hits, %u skipped writes, %u invalidations\n",
+         shadow.hits, shadow.skippedWrites, shadow.invalidations);
+  printf("  redraws: %u transactions, %u refs deferred, %u sent, %u overflows\n",
+         redraw.transactions, redraw.deferred, redraw.refs, redraw.overflows);
+  return 0;
+}
+
+static uint32_t eventCounts[6];
+static unsigned long eventHandled;
+
+static void onEventPush(void *ptr) { eventCounts[0]++; eventHandled = micros(); }
+static void onEventPage(uint8_t pid) { eventCounts[1]++; eventHandled = micros(); }
+static void onEventPosition(uint16_t x, uint16_t y, bool press, bool sleeping) { eventCounts[2]++; eventHandled = micros(); }
+static void onEventCode(uint8_t code) { eventCounts[3]++; eventHandled = micros(); }
+static void onEventNumber(uint32_t number) { eventCounts[4]++; eventHandled = micros(); }
+static void onEventString(const char *str, uint16_t len) { eventCounts[5]++; eventHandled = micros(); }
+
+/*** Sends count frames the display sends by itself, one at a time, and
+ * measures on the virtual clock how long it takes before nexLoop, called
+ * every loopUs, passes them to their handler
+*/
+static int benchEvents(uint32_t count, uint32_t loopUs)
+{
+  static const uint8_t frames[][12] = {
+      {0x65, 0, 1, 1, 0xFF, 0xFF, 0xFF},                         // touch b0
+      {0x66, 1, 0xFF, 0xFF, 0xFF},                               // page 1
+      {0x67, 0x01, 0x90, 0x00, 0xF0, 1, 0xFF, 0xFF, 0xFF},       // touch at 400,240
+      {0x86, 0xFF, 0xFF, 0xFF},                                  // sleep
+      {0x71, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},          // print -1
+      {0x70, 'W', 'i', 'n', 'd', 0xFF, 0xFF, 0xFF}};             // prints "Wind"
+  static const uint8_t sizes[] = {7, 5, 9, 4, 8, 8};
+  static const NexHandlers handlers = {onEventPage, onEventPosition, onEventCode, NULL,
+                                       onEventNumber, onEventString};
+  NexButton b0(0, 1, "b0");
+  NexTouch *listenList[] = {&b0, NULL};
+  uint64_t totalUs = 0;
+  uint32_t maxUs = 0;
+  uint64_t totalLastUs = 0;
+  uint32_t maxLastUs = 0;
+  uint32_t lost = 0;
+
+  nativeSetVirtualClock(true);
+  dbTransport = &nowhere;
+  nexInit();
+  b0.attachPush(onEventPush);
+  nexSetHandlers(&handlers);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    uint8_t kind = i % 6;
+    uint32_t handled = eventCounts[kind];
+    unsigned long start = micros();
+    emulator.sendFrame(frames[kind], sizes[kind]);
+    while (eventCounts[kind] == handled && micros() - start < 100000)
+    {
+      nexLoop(listenList);
+      nativeAdvanceClock(loopUs);
+    }
+    if (eventCounts[kind] == handled)
+    {
+      lost++;
+      continue;
+    }
+    uint32_t us = eventHandled - start;
+    totalUs += us;
+    maxUs = us > maxUs ? us : maxUs;
+    // the last byte is on the line 10 bit times per byte after the start
+    uint32_t lastUs = start + sizes[kind] * 10000000ULL / emulator.displayBaud();
+    us = eventHandled > lastUs ? eventHandled - lastUs : 0;
+    totalLastUs += us;
+    maxLastUs = us > maxLastUs ? us : maxLastUs;
+  }
+  const NexRxStats &rx = nexRxStats();
+  printf("%u events at %u Bd, nexLoop every %uus\n", count, emulator.displayBaud(), loopUs);
+  printf("  touch %u, page %u, position %u, event %u, number %u, string %u, lost %u\n",
+         eventCounts[0], eventCounts[1], eventCounts[2], eventCounts[3], eventCounts[4],
+         eventCounts[5], lost);
+  printf("  sent to handler: avg %lluus max %uus\n",
+         (unsigned long long)(count > lost ? totalUs / (count - lost) : 0), maxUs);
+  printf("  last byte to handler: avg %lluus max %uus\n",
+         (unsigned long long)(count > lost ? totalLastUs / (count - lost) : 0), maxLastUs);
+  printf("  %u frames, %u dispatched, %u invalid\n", rx.frames, rx.dispatched, rx.invalid);
+  return lost ? 1 : 0;
+}
+
+static double wallSeconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t touchCount;
+
+static void onTouch(void *ptr) { touchCount++; }
+
+/*** A button of the touch benchmark, with the ids its walk compares
+*/
+class BenchButton : public NexButton
+{
+public:
+  BenchButton(uint8_t pid, uint8_t cid) : NexButton(pid, cid, "b") {}
+  uint8_t pid() { return getObjPid(); }
+  uint8_t cid() { return getObjCid(); }
+};
+
+/*** Finds the button of an event by walking the list from the start, like
+ * NexTouch::iterate did before the index, and makes its callback
+*/
+static void walkTouch(BenchButton **list, uint8_t pid, uint8_t cid)
+{
+  for (uint8_t i = 0; list[i] != NULL; i++)
+  {
+    if (list[i]->pid() == pid && list[i]->cid() == cid)
+    {
+      onTouch(list[i]);
+      return;
+    }
+  }
+}
+
+/*** Dispatches count touch events, spread over 48 buttons on 4 pages, with
+ * NexTouch::iterate and with the walk of the buttons it did before the index
+*/
+static int benchTouch(uint32_t count)
+{
+  static const uint8_t nr = 48;
+  static BenchButton *buttons[nr + 1];
+  NexTouch *listenList[nr + 1];
+  uint32_t seed = 1;
+
+  dbTransport = &nowhere;
+  for (uint8_t i = 0; i < nr; i++)
+  {
+    buttons[i] = new BenchButton(i / 12, 2 + i % 12);
+    buttons[i]->attachPush(onTouch);
+    listenList[i] = buttons[i];
+  }
+  buttons[nr] = NULL;
+  listenList[nr] = NULL;
+  NexTouch::iterate(listenList, 0xFF, 0xFF, NEX_EVENT_PUSH); // builds the index
+
+  double start = wallSeconds();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    uint8_t n = (seed >> 16) % nr;
+    NexTouch::iterate(listenList, n / 12, 2 + n % 12, NEX_EVENT_PUSH);
+  }
+  double indexed = wallSeconds() - start;
+  uint32_t indexedCount = touchCount;
+
+  touchCount = 0;
+  seed = 1;
+  start = wallSeconds();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    uint8_t n = (seed >> 16) % nr;
+    walkTouch(buttons, n / 12, 2 + n % 12);
+  }
+  double walked = wallSeconds() - start;
+
+  printf("%u touch events on %u components\n", count, nr);
+  printf("  indexed: %.1fns per event, %u callbacks\n", indexed * 1e9 / count, indexedCount);
+  printf("  walked:  %.1fns per event, %u callbacks\n", walked * 1e9 / count, touchCount);
+  return indexedCount == count && touchCount == count ? 0 : 1;
+}
+
+/*** Times count calculations of the true wind kernel, in float and in
+ * double; its accuracy is checked by the unit tests in test/test_truewind
+*/
+static int benchTrueWind(uint32_t count)
+{
+  // pseudo random inputs, the same for every kernel
+  static int32_t inputs[1024][4];
+  uint32_t seed = 1;
+  for (int i = 0; i < 1024; i++)
+  {
+    for (int j = 0; j < 4; j++)
+    {
+      seed = seed * 1103515245 + 12345;
+      inputs[i][j] = (seed >> 16) % (j == 1 ? 3600 : 600) - (j == 1 ? 1800 : 0);
+    }
+  }
+  volatile int32_t sink = 0;
+  double start = wallSeconds();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    const int32_t *in = inputs[i & 1023];
+    TrueWind tw;
+    twCalculate(in[0], in[1], in[2], in[3], &tw);
+    sink = sink + tw.tws + tw.twd + tw.vmg;
+  }
+  double fixed = wallSeconds() - start;
+  start = wallSeconds();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    const int32_t *in = inputs[i & 1023];
+    float tw[4];
+    trueWindFloat(in[0], in[1], in[2], in[3], tw);
+    sink = sink + (int32_t)tw[0] + (int32_t)tw[2] + (int32_t)tw[3];
+  }
+  double single = wallSeconds() - start;
+  start = wallSeconds();
+  for (uint32_t i = 0; i < count; i++)
+  {
+    const int32_t *in = inputs[i & 1023];
+    double tw[4];
+    trueWindDouble(in[0], in[1], in[2], in[3], tw);
+    sink = sink + (int32_t)tw[0] + (int32_t)tw[2] + (int32_t)tw[3];
+  }
+  double dbl = wallSeconds() - start;
+  printf("%u calculations of TWS, TWA, TWD and VMG\n", count);
+  printf("  fixed:  %.1fns each\n", fixed * 1e9 / count);
+  printf("  float:  %.1fns each\n", single * 1e9 / count);
+  printf("  double: %.1fns each\n", dbl * 1e9 / count);
+  return 0;
+}
+
+/*** Parses the log in memory passes times, with the receiver and parser of
+ * version 1.35, which collect a sentence and then scan it again as String,
+ * and with the streaming receiver, which validates and splits it while it
+ * is received, and the sentence handlers of the firmware
+*/
+static int benchParser(const char *path, uint32_t passes)
+{
+  FILE *f = fopen(path, "rb");
+  if (f == NULL)
+  {
+    perror(path);
+    return 1;
+  }
+  static char log[1 << 20];
+  size_t len = fread(log, 1, sizeof(log), f);
+  fclose(f);
+
+  dbTransport = &nowhere;
+  uint32_t legacySentences = 0;
+  uint32_t allocs = nativeHeapAllocs();
+  double start = wallSeconds();
+  for (uint32_t n = 0; n < passes; n++)
+  {
+    for (size_t i = 0; i < len; i++)
+    {
+      if (legacyRecv(log[i]))
+      {
+        legacyProcess();
+        legacySentences++;
+      }
+    }
+  }
+  double legacy = wallSeconds() - start;
+  uint32_t legacyAllocs = nativeHeapAllocs() - allocs;
+
+  NmeaReceiver receiver;
+  NmeaSentence sentence;
+  uint32_t sentences = 0;
+  receiver.setBuffer(&sentence);
+  allocs = nativeHeapAllocs();
+  start = wallSeconds();
+  for (uint32_t n = 0; n < passes; n++)
+  {
+    for (size_t i = 0; i < len; i++)
+    {
+      if (receiver.feed(log[i]))
+      {
+        processNMEAData(sentence);
+        sentences++;
+      }
+    }
+  }
+  double streaming = wallSeconds() - start;
+  uint32_t streamingAllocs = nativeHeapAllocs() - allocs;
+
+  printf("%u bytes parsed %u times, last AWA %s\n", (unsigned)len, passes, legacyAWA());
+  printf("  String/indexOf: %u sentences, %.0f sentences/s, %.1f allocations per sentence\n",
+         legacySentences, legacy > 0 ? legacySentences / legacy : 0.0,
+         legacySentences ? (double)legacyAllocs / legacySentences : 0.0);
+  printf("  streaming:      %u sentences, %.0f sentences/s, %.1f allocations per sentence, %u checksum errors\n",
+         sentences, streaming > 0 ? sentences / streaming : 0.0,
+         sentences ? (double)streamingAllocs / sentences : 0.0, receiver.stats().checksumErrors);
+  return 0;
+}
+
+/*** Replays a log through recvNMEAData, processNMEAData and displayData
+ * on the virtual clock and reports the throughput
+*/
+static int replay(uint32_t loopUs, uint32_t bootMs)
+{
+  unsigned long selftestUs = 0;
+
+  nativeSetVirtualClock(true);
+  if (bootMs > 0)
+  {
+    emulator.powerOn(bootMs * 1000);
+    emulator.setNumber("status.pic", EMULATOR_SELFTEST_PIC);
+    selftestUs = micros() + (bootMs + EMULATOR_SELFTEST) * 1000UL;
+  }
+  unsigned long startUs = micros();
+  setup();
+
+  // the boot of the display is not part of the frame statistics, they
+  // start with the first frame
+  HmiFrameStats startFrame = hmiFrame.stats();
+  NexTxStats startTx = nexTxStats();
+  uint32_t startAllocs = nativeHeapAllocs();
+  uint32_t startDerivations = navState.derivations();
+  uint32_t firstSentences = 0;
+  double startWall = wallSeconds();
+  // a fast replay may end before the display is booted, which then still
+  // gets the first frame with the values received
+  while (!nmeaReplay.eof() ||
+         (firstFrameMs == 0 && micros() - startUs < REPLAY_BOOT_TIMEOUT * 1000UL))
+  {
+    if (firstFrameMs == 0)
+    {
+      firstSentences = nmeaReceiver.stats().sentences;
+      startFrame = hmiFrame.stats();
+      startTx = nexTxStats();
+      startAllocs = nativeHeapAllocs();
+      startDerivations = navState.derivations();
+    }
+    loop();
+    nativeAdvanceClock(loopUs);
+    if (selftestUs && micros() >= selftestUs)
+    {
+      emulator.setNumber("status.pic", EMULATOR_HMI_OK);
+      selftestUs = 0;
+    }
+  }
+  // let the last frame go out
+  for (int i = 0; i < 1000; i++)
+  {
+    loop();
+    nativeAdvanceClock(loopUs);
+  }
+  uint32_t allocs = nativeHeapAllocs() - startAllocs;
+  double wall = wallSeconds() - startWall;
+  double virt = (micros() - startUs) / 1e6;
+
+  const NmeaReplayStats &r = nmeaReplay.stats();
+  const NmeaStats &n = nmeaReceiver.stats();
+  const HmiFrameStats &f = hmiFrame.stats();
+  uint32_t frames = f.frames - startFrame.frames;
+  uint32_t frameBytes = f.bytes - startFrame.bytes;
+  uint32_t fullBytes = f.fullBytes - startFrame.fullBytes;
+  uint32_t dropped = r.lines > n.sentences ? r.lines - n.sentences : 0;
+  dropped += nmeaRing.overflows();
+
+  printf("Replay: %u sentences, %u bytes, %u bytes lost in %u sentences\n",
+         r.lines, r.bytes, r.bytesLost, r.linesHit);
+  printf("  valid %u, checksum errors %u, too long %u, ring overflows %u => dropped %u\n",
+         n.sentences, n.checksumErrors, n.overflows, nmeaRing.overflows(), dropped);
+  printf("  virtual %.2fs: %.1f sentences/s, %u frames, %.1f frames/s\n",
+         virt, virt > 0 ? n.sentences / virt : 0.0, frames, virt > 0 ? frames / virt : 0.0);
+  printf("  wall    %.3fs: %.0f sentences/s\n", wall, wall > 0 ? n.sentences / wall : 0.0);
+  printf("Boot: first frame after %lums, %u sentences received before\n",
+         firstFrameMs, firstSentences);
+  printf("Frames: %u keys, %u bytes of %u with all keys (%.0f%% saved), %u full frames\n",
+         f.keys - startFrame.keys, frameBytes, fullBytes,
+         fullBytes > 0 ? 100.0 - 100.0 * frameBytes / fullBytes : 0.0,
+         f.fullFrames - startFrame.fullFrames);
+  uint32_t derivations = navState.derivations() - startDerivations;
+  printf("Derived: %u node recalculations, %.2f per frame\n",
+         derivations, frames > 0 ? (double)derivations / frames : 0.0);
+  const NexAsyncStats &a = nexAsyncStats();
+  printf("Commands: %u sent, %u acked, %u failed, %u timeouts, %u resyncs, %u dropped, %u stalls, max %u in flight\n",
+         a.sent, a.acked, a.failed, a.timeouts, a.resyncs, a.dropped, a.stalls, a.maxPending);
+  const NexTxStats &t = nexTxStats();
+  uint32_t batches = t.batches - startTx.batches;
+  printf("Transmit: %u commands, %u bytes in %u writes, %u batches, %.1f bytes and %.2f writes per frame\n",
+         t.commands - startTx.commands, t.bytes - startTx.bytes, t.writes - startTx.writes, batches,
+         frames > 0 ? (double)(t.bytes - startTx.bytes) / frames : 0.0,
+         frames > 0 ? (double)(t.writes - startTx.writes) / frames : 0.0);
+#ifdef WRITE_ENABLED
+  const NmeaRelayStats &rs = nmeaRelay.stats();
+  printf("Relay: %u bytes, %.1f bytes/s, relayed/dropped per priority:",
+         rs.bytes, virt > 0 ? rs.bytes / virt : 0.0);
+  for (int i = 0; i < NMEA_RELAY_PRIORITIES; i++)
+  {
+    printf(" %u/%u", rs.relayed[i], rs.dropped[i]);
+  }
+  printf("\n");
+#endif
+  printf("Heap: %u allocations, %.1f per frame\n", allocs, frames > 0 ? (double)allocs / frames : 0.0);
+  if (nexTransport == &emulator)
+  {
+    printEmulatorStats();
+  }
+  return 0;
+}
+
+/*** Serves the emulator on a pty until the process is killed
+*/
+static int servePty()
+{
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+  {
+    perror("pty");
+    return 1;
+  }
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+  printf("%s\n", ptsname(master));
+  fflush(stdout);
+
+  // a pty has no baudrate, so the host always matches the display
+  for (;;)
+  {
+    uint8_t buf[256];
+    ssize_t n = ::read(master, buf, sizeof(buf));
+    emulator.begin(emulator.displayBaud());
+    if (n > 0)
+    {
+      emulator.write(buf, n);
+    }
+    while (emulator.available() > 0)
+    {
+      uint8_t c = emulator.read();
+      if (::write(master, &c, 1) != 1)
+      {
+        break;
+      }
+    }
+    usleep(100);
+  }
+  return 0;
+}
+
+#ifndef PIO_UNIT_TESTING
+int main(int argc, char **argv)
+{
+  const char *nextionDevice = NULL;
+  uint32_t benchCount = 0;
+  uint32_t themeCount = 0;
+  uint32_t eventCount = 0;
+  uint32_t touchEvents = 0;
+  uint32_t windCount = 0;
+  uint32_t parserPasses = 0;
+  uint32_t bootMs = 0;
+  uint32_t benchBaud = 0;
+  uint32_t loopUs = 100;
+  bool pty = false;
+  struct stat st;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:l:B:M:b:s:e:i:w:P:pr:c:t:o:R:")) != -1)
+  {
+    switch (opt)
+    {
+    case 'n':
+      nextionDevice = optarg;
+      break;
+    case 'l':
+      emulator.setAckLatency(strtoul(optarg, NULL, 10));
+      break;
+    case 'B':
+      benchBaud = strtoul(optarg, NULL, 10);
+      break;
+    case 'M':
+      emulator.setMaxBaud(strtoul(optarg, NULL, 10));
+      break;
+    case 'b':
+      benchCount = strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      themeCount = strtoul(optarg, NULL, 10);
+      break;
+    case 'e':
+      eventCount = strtoul(optarg, NULL, 10);
+      break;
+    case 'i':
+      touchEvents = strtoul(optarg, NULL, 10);
+      break;
+    case 'w':
+      windCount = strtoul(optarg, NULL, 10);
+      break;
+    case 'P':
+      parserPasses = strtoul(optarg, NULL, 10);
+      break;
+    case 'p':
+      pty = true;
+      break;
+    case 'r':
+      nmeaReplay.setRate(strtod(optarg, NULL));
+      break;
+    case 'c':
+      nmeaReplay.setRxCapacity(strtoul(optarg, NULL, 10));
+      break;
+    case 't':
+      loopUs = strtoul(optarg, NULL, 10);
+      break;
+    case 'o':
+      bootMs = strtoul(optarg, NULL, 10);
+      break;
+    case 'R':
+#ifdef WRITE_ENABLED
+      nmeaRelay.setRate(strtoul(optarg, NULL, 10));
+#endif
+      break;
+    default:
+      fprintf(stderr, "usage: %s [-n nextion device] [-l ack latency us] [-B baud] [-M baud]\n"
+                      "          [-b count] [-s count]\n"
+                      "          [-e count] [-i count] [-w count] [-P passes] [-p] [-r rate] [-c rx buffer] [-t loop us]\n"
+                      "          [-o boot ms] [-R relay bytes/s] <nmea input>\n", argv[0]);
+      return 1;
+    }
+  }
+
+  // the HMI sets its status picture to OK after the selftest
+  emulator.setNumber("status.pic", EMULATOR_HMI_OK);
+  if (pty)
+  {
+    return servePty();
+  }
+  if (benchCount > 0)
+  {
+    return benchNextion(benchCount, benchBaud);
+  }
+  if (themeCount > 0)
+  {
+    return benchThemes(themeCount);
+  }
+  if (eventCount > 0)
+  {
+    return benchEvents(eventCount, loopUs);
+  }
+  if (touchEvents > 0)
+  {
+    return benchTouch(touchEvents);
+  }
+  if (windCount > 0)
+  {
+    return benchTrueWind(windCount);
+  }
+  if (optind >= argc)
+  {
+    fprintf(stderr, "%s: no nmea input\n", argv[0]);
+    return 1;
+  }
+  if (parserPasses > 0)
+  {
+    return benchParser(argv[optind], parserPasses);
+  }
+  if (nextionDevice != NULL)
+  {
+    if (!nextionLink.open(nextionDevice))
+    {
+      perror(nextionDevice);
+      return 1;
+    }
+    nexTransport = &nextionLink;
+  }
+
+  if (stat(argv[optind], &st) == 0 && S_ISREG(st.st_mode) && nextionDevice == NULL)
+  {
+    if (!nmeaReplay.open(argv[optind]))
+    {
+      perror(argv[optind]);
+      return 1;
+    }
+    nmeaTransport = &nmeaReplay;
+    return replay(loopUs, bootMs);
+  }
+
+  // live input, runs on the real clock
+  if (!nmeaInput.open(argv[optind]))
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+  nmeaTransport = &nmeaInput;
+
+  setup();
+  while (!nmeaInput.eof())
+  {
+    loop();
+  }
+  loop(); // process the last sentences
+  const NexAsyncStats &a = nexAsyncStats();
+  printf("Commands: %u sent, %u acked, %u failed, %u timeouts, %u resyncs, %u dropped, %u stalls, max %u in flight\n",
+         a.sent, a.acked, a.failed, a.timeouts, a.resyncs, a.dropped, a.stalls, a.maxPending);
+  if (nexTransport == &emulator)
+  {
+    printEmulatorStats();
+  }
+  return 0;
+}
+#endif /* #ifndef PIO_UNIT_TESTING */
+
+#endif
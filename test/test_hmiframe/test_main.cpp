@@ -0,0 +1,112 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     test_hmiframe/test_main.cpp
+  Purpose:  Unit tests of the delta encoder of the HMI frames, run with:
+            pio test -e native
+*/
+#include <Arduino.h>
+#include <unity.h>
+#include "HmiFrame.h"
+
+#define FULL_FRAME "COG=---.-#AWA=--.-#SOG=--.-#AWS=--.-#BAT=--.-#DPT=--.-#" \
+                   "TWS=--.-#TWA=--.-#TWD=---.-#VMG=--.-#MWD=---.-#MXW=--.-#"
+
+static NavState state;
+static HmiFrame frame;
+static char buf[HMI_FRAME_SIZE];
+
+/*** Encodes a frame at now like displayData() and cleans the state
+ * @return the frame
+ */
+static const char *encode(unsigned long now)
+{
+  uint8_t len = frame.encode(state, now, buf);
+  TEST_ASSERT_EQUAL_UINT8(strlen(buf), len);
+  state.clean();
+  return buf;
+}
+
+void setUp(void)
+{
+  state = NavState();
+  frame = HmiFrame();
+}
+
+void tearDown(void)
+{
+}
+
+void test_first_frame_has_all_keys(void)
+{
+  TEST_ASSERT_EQUAL_STRING(FULL_FRAME, encode(0));
+  TEST_ASSERT_EQUAL_UINT32(1, frame.stats().fullFrames);
+}
+
+void test_only_changes(void)
+{
+  encode(0);
+  state.set(NAV_AWA, -375);
+  state.set(NAV_COG, 2132);
+  TEST_ASSERT_EQUAL_STRING("COG=213.2#AWA=-37.5#", encode(100));
+  // the same values again are not sent
+  state.set(NAV_AWA, -375);
+  TEST_ASSERT_EQUAL_UINT8(0, frame.encode(state, 200, buf));
+  state.set(NAV_AWA, -374);
+  TEST_ASSERT_EQUAL_STRING("AWA=-37.4#", encode(300));
+}
+
+void test_invalid_placeholder(void)
+{
+  encode(0);
+  state.set(NAV_DPT, 31);
+  TEST_ASSERT_EQUAL_STRING("DPT=3.1#", encode(100));
+  state.invalidate(NAV_DPT);
+  TEST_ASSERT_EQUAL_STRING("DPT=--.-#", encode(200));
+}
+
+void test_refresh(void)
+{
+  encode(0);
+  TEST_ASSERT_EQUAL_UINT8(0, frame.encode(state, HMI_FRAME_REFRESH - 1, buf));
+  TEST_ASSERT_EQUAL_STRING(FULL_FRAME, encode(HMI_FRAME_REFRESH));
+  frame.refresh();
+  TEST_ASSERT_EQUAL_STRING(FULL_FRAME, encode(HMI_FRAME_REFRESH + 1));
+  TEST_ASSERT_EQUAL_UINT32(3, frame.stats().fullFrames);
+}
+
+void test_stats(void)
+{
+  encode(0);
+  state.set(NAV_SOG, 64);
+  encode(100);
+  const HmiFrameStats &s = frame.stats();
+  TEST_ASSERT_EQUAL_UINT32(2, s.frames);
+  TEST_ASSERT_EQUAL_UINT32(NAV_KEYS + 1, s.keys);
+  TEST_ASSERT_EQUAL_UINT32(strlen(FULL_FRAME) + strlen("SOG=6.4#"), s.bytes);
+  // the second frame with all keys is one character shorter
+  TEST_ASSERT_EQUAL_UINT32(2 * strlen(FULL_FRAME) - 1, s.fullBytes);
+}
+
+/*** The longest frame fits the txt_maxl the HMI needs and the buffer
+ */
+void test_longest_frame(void)
+{
+  for (uint8_t key = 0; key < NAV_KEYS; key++)
+  {
+    state.set(key, INT32_MIN);
+  }
+  TEST_ASSERT_EQUAL_UINT8(HMI_TXT_MAXL, strlen(encode(0)));
+  TEST_ASSERT_TRUE(HMI_TXT_MAXL < HMI_FRAME_SIZE);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_first_frame_has_all_keys);
+  RUN_TEST(test_only_changes);
+  RUN_TEST(test_invalid_placeholder);
+  RUN_TEST(test_refresh);
+  RUN_TEST(test_stats);
+  RUN_TEST(test_longest_frame);
+  return UNITY_END();
+}
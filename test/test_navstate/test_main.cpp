@@ -0,0 +1,135 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     test_navstate/test_main.cpp
+  Purpose:  Unit tests of the dirty bits and the derived values of the
+            NavState, run with: pio test -e native
+*/
+#include <Arduino.h>
+#include <unity.h>
+#include "NavState.h"
+
+static NavState state;
+static uint8_t sumRuns;
+static uint8_t doubleRuns;
+
+//*** test nodes: TWS = AWS + SOG and TWD = 2 * TWS
+static void deriveSum(NavState &s)
+{
+  sumRuns++;
+  s.set(NAV_TWS, s.tenths(NAV_AWS) + s.tenths(NAV_SOG));
+}
+
+static void deriveDouble(NavState &s)
+{
+  doubleRuns++;
+  s.set(NAV_TWD, 2 * s.tenths(NAV_TWS));
+}
+
+static const NavNode nodes[] = {
+    {NAV_BIT(NAV_AWS) | NAV_BIT(NAV_SOG), deriveSum},
+    {NAV_BIT(NAV_TWS), deriveDouble},
+};
+
+void setUp(void)
+{
+  state = NavState();
+  state.setNodes(nodes, sizeof(nodes) / sizeof(nodes[0]));
+  sumRuns = doubleRuns = 0;
+}
+
+void tearDown(void)
+{
+}
+
+void test_invalid_until_set(void)
+{
+  TEST_ASSERT_FALSE(state.valid(NAV_AWA));
+  TEST_ASSERT_EQUAL_HEX16(0, state.dirty());
+  state.set(NAV_AWA, -375);
+  TEST_ASSERT_TRUE(state.valid(NAV_AWA));
+  TEST_ASSERT_EQUAL_INT32(-375, state.tenths(NAV_AWA));
+}
+
+void test_dirty_on_change(void)
+{
+  state.set(NAV_AWA, 0);
+  TEST_ASSERT_EQUAL_HEX16(NAV_BIT(NAV_AWA), state.dirty());
+  state.clean();
+  state.set(NAV_AWA, 0);
+  TEST_ASSERT_EQUAL_HEX16(0, state.dirty());
+  state.set(NAV_AWA, 1);
+  state.set(NAV_DPT, 31);
+  TEST_ASSERT_EQUAL_HEX16(NAV_BIT(NAV_AWA) | NAV_BIT(NAV_DPT), state.dirty());
+}
+
+void test_dirty_on_invalidate(void)
+{
+  state.invalidate(NAV_BAT);
+  TEST_ASSERT_EQUAL_HEX16(0, state.dirty());
+  state.set(NAV_BAT, 124);
+  state.clean();
+  state.invalidate(NAV_BAT);
+  TEST_ASSERT_EQUAL_HEX16(NAV_BIT(NAV_BAT), state.dirty());
+  TEST_ASSERT_FALSE(state.valid(NAV_BAT));
+  // set again with the old value, it is valid again so it changed
+  state.clean();
+  state.set(NAV_BAT, 124);
+  TEST_ASSERT_EQUAL_HEX16(NAV_BIT(NAV_BAT), state.dirty());
+}
+
+void test_derive_in_order(void)
+{
+  state.set(NAV_AWS, 100);
+  state.set(NAV_SOG, 50);
+  state.derive();
+  TEST_ASSERT_EQUAL_INT32(150, state.tenths(NAV_TWS));
+  TEST_ASSERT_EQUAL_INT32(300, state.tenths(NAV_TWD));
+  TEST_ASSERT_EQUAL_UINT8(1, sumRuns);
+  TEST_ASSERT_EQUAL_UINT8(1, doubleRuns);
+  TEST_ASSERT_EQUAL_UINT32(2, state.derivations());
+  TEST_ASSERT_TRUE(state.dirty() & NAV_BIT(NAV_TWD));
+}
+
+void test_derive_only_dirty(void)
+{
+  state.set(NAV_AWS, 100);
+  state.set(NAV_SOG, 50);
+  state.derive();
+  state.clean();
+  // a value no node depends on doesn't recalculate anything
+  state.set(NAV_DPT, 31);
+  state.derive();
+  TEST_ASSERT_EQUAL_UINT8(1, sumRuns);
+  // an output that doesn't change doesn't recalculate the nodes after it
+  state.set(NAV_AWS, 110);
+  state.set(NAV_SOG, 40);
+  state.derive();
+  TEST_ASSERT_EQUAL_UINT8(2, sumRuns);
+  TEST_ASSERT_EQUAL_UINT8(1, doubleRuns);
+  TEST_ASSERT_FALSE(state.dirty() & NAV_BIT(NAV_TWS));
+}
+
+void test_format(void)
+{
+  char buf[NAV_TEXT_SIZE];
+  TEST_ASSERT_EQUAL_UINT8(3, navFormatTenths(0, buf));
+  TEST_ASSERT_EQUAL_STRING("0.0", buf);
+  navFormatTenths(-5, buf);
+  TEST_ASSERT_EQUAL_STRING("-0.5", buf);
+  navFormatTenths(2132, buf);
+  TEST_ASSERT_EQUAL_STRING("213.2", buf);
+  TEST_ASSERT_EQUAL_UINT8(NAV_TEXT_SIZE - 1, navFormatTenths(INT32_MIN, buf));
+  TEST_ASSERT_EQUAL_STRING("-214748364.8", buf);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_invalid_until_set);
+  RUN_TEST(test_dirty_on_change);
+  RUN_TEST(test_dirty_on_invalidate);
+  RUN_TEST(test_derive_in_order);
+  RUN_TEST(test_derive_only_dirty);
+  RUN_TEST(test_format);
+  return UNITY_END();
+}
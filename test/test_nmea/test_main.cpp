@@ -0,0 +1,179 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     test_nmea/test_main.cpp
+  Purpose:  Unit tests of the streaming NMEA receiver: checksum, splitting
+            in fields and the parsing of values, run with: pio test -e native
+*/
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+#include "NmeaParser.h"
+
+#define TEST_LOG "test/data/test.nmea" // relative to the project directory
+
+static NmeaReceiver receiver;
+static NmeaSentence sentence;
+
+/*** Feeds text to the receiver
+ * @return the nr of sentences completed
+ */
+static uint8_t feed(const char *text)
+{
+  uint8_t complete = 0;
+  while (*text)
+  {
+    complete += receiver.feed(*text++) ? 1 : 0;
+  }
+  return complete;
+}
+
+/*** Returns field i of the last sentence as string
+*/
+static const char *field(uint8_t i)
+{
+  static char buf[NMEA_BUFFER_SIZE];
+  nmeaFieldCopy(sentence.field(i), buf, sizeof(buf));
+  return buf;
+}
+
+static NmeaField span(const char *text)
+{
+  NmeaField f = {text, (uint8_t)strlen(text)};
+  return f;
+}
+
+void setUp(void)
+{
+  receiver = NmeaReceiver();
+  receiver.setBuffer(&sentence);
+}
+
+void tearDown(void)
+{
+}
+
+void test_checksum(void)
+{
+  TEST_ASSERT_EQUAL_UINT8(1, feed("$IIMWV,030,R,12.0,N,A*13\r\n"));
+  TEST_ASSERT_EQUAL_UINT8(1, feed("$iimwv,030,R,12.0,N,A*33\r\n"));
+  // a wrong or incomplete checksum drops the sentence
+  TEST_ASSERT_EQUAL_UINT8(0, feed("$IIMWV,030,R,12.0,N,A*14\r\n"));
+  TEST_ASSERT_EQUAL_UINT8(0, feed("$IIMWV,031,R,12.0,N,A*13\r\n"));
+  TEST_ASSERT_EQUAL_UINT8(0, feed("$IIMWV,030,R,12.0,N,A*1\r\n"));
+  TEST_ASSERT_EQUAL_UINT8(0, feed("$IIMWV,030,R,12.0,N,A*1G\r\n"));
+  TEST_ASSERT_EQUAL_UINT32(2, receiver.stats().sentences);
+  TEST_ASSERT_TRUE(receiver.stats().checksumErrors >= 2);
+}
+
+void test_unchecked(void)
+{
+#ifdef NMEA_REQUIRE_CHECKSUM
+  TEST_ASSERT_EQUAL_UINT8(0, feed("$IITOB,12.0\r\n"));
+#else
+  TEST_ASSERT_EQUAL_UINT8(1, feed("$IITOB,12.0\r\n"));
+  TEST_ASSERT_EQUAL_UINT32(1, receiver.stats().unchecked);
+#endif
+}
+
+void test_fields(void)
+{
+  TEST_ASSERT_EQUAL_UINT8(1, feed("$GPRMC,120000,A,5200.0,N,00400.0,E,6.0,210.0,010120,,*1A\r\n"));
+  TEST_ASSERT_EQUAL_UINT32(NMEA_ID('R', 'M', 'C'), sentence.id);
+  TEST_ASSERT_EQUAL_UINT8(12, sentence.nrOfFields);
+  TEST_ASSERT_EQUAL_STRING("$GPRMC", field(0));
+  TEST_ASSERT_EQUAL_STRING("120000", field(1));
+  TEST_ASSERT_EQUAL_STRING("6.0", field(7));
+  TEST_ASSERT_EQUAL_STRING("210.0", field(8));
+  // empty fields, the checksum is not part of the last one
+  TEST_ASSERT_EQUAL_STRING("", field(10));
+  TEST_ASSERT_EQUAL_STRING("", field(11));
+  TEST_ASSERT_EQUAL_UINT8(0, sentence.field(12).len);
+  TEST_ASSERT_EQUAL_UINT8(0, sentence.field(200).len);
+}
+
+void test_resync(void)
+{
+  // garbage and a sentence cut off by a new '$' are skipped
+  TEST_ASSERT_EQUAL_UINT8(1, feed("xx,12*00\r\n$IIMWV,03$SDDBT,10.0,f,3.0,M,1.7,F*32\r\n"));
+  TEST_ASSERT_EQUAL_UINT32(NMEA_ID('D', 'B', 'T'), sentence.id);
+  TEST_ASSERT_EQUAL_STRING("3.0", field(3));
+}
+
+void test_too_long(void)
+{
+  char line[128] = "$IIXDR";
+  while (strlen(line) < 100)
+  {
+    strcat(line, ",1.0");
+  }
+  strcat(line, "\r\n");
+  TEST_ASSERT_EQUAL_UINT8(0, feed(line));
+  TEST_ASSERT_EQUAL_UINT32(1, receiver.stats().overflows);
+  TEST_ASSERT_EQUAL_UINT8(1, feed("$IITOB,12.0*68\r\n"));
+}
+
+void test_field_copy(void)
+{
+  char buf[4];
+  nmeaFieldCopy(span("12345"), buf, sizeof(buf));
+  TEST_ASSERT_EQUAL_STRING("123", buf);
+  nmeaFieldCopy(span(""), buf, sizeof(buf));
+  TEST_ASSERT_EQUAL_STRING("", buf);
+}
+
+void test_field_tenths(void)
+{
+  int32_t tenths = 0;
+  TEST_ASSERT_TRUE(nmeaFieldTenths(span("12.3"), &tenths));
+  TEST_ASSERT_EQUAL_INT32(123, tenths);
+  TEST_ASSERT_TRUE(nmeaFieldTenths(span("-37.5"), &tenths));
+  TEST_ASSERT_EQUAL_INT32(-375, tenths);
+  TEST_ASSERT_TRUE(nmeaFieldTenths(span("030"), &tenths));
+  TEST_ASSERT_EQUAL_INT32(300, tenths);
+  // rounded at the second decimal
+  TEST_ASSERT_TRUE(nmeaFieldTenths(span("1.25"), &tenths));
+  TEST_ASSERT_EQUAL_INT32(13, tenths);
+  TEST_ASSERT_TRUE(nmeaFieldTenths(span("214748363.9"), &tenths));
+  TEST_ASSERT_EQUAL_INT32(2147483639, tenths);
+  TEST_ASSERT_FALSE(nmeaFieldTenths(span(""), &tenths));
+  TEST_ASSERT_FALSE(nmeaFieldTenths(span("-"), &tenths));
+  TEST_ASSERT_FALSE(nmeaFieldTenths(span("1.2.3"), &tenths));
+  TEST_ASSERT_FALSE(nmeaFieldTenths(span("12a"), &tenths));
+  TEST_ASSERT_FALSE(nmeaFieldTenths(span("999999999999"), &tenths));
+}
+
+/*** Every sentence of the log of the native build is valid
+ */
+void test_log(void)
+{
+  FILE *f = fopen(TEST_LOG, "rb");
+  if (f == NULL)
+  {
+    TEST_IGNORE_MESSAGE(TEST_LOG " not found, run from the project directory");
+  }
+  uint32_t lines = 0;
+  int c;
+  while ((c = fgetc(f)) != EOF)
+  {
+    lines += c == '\n' ? 1 : 0;
+    receiver.feed(c);
+  }
+  fclose(f);
+  TEST_ASSERT_TRUE(lines > 0);
+  TEST_ASSERT_EQUAL_UINT32(lines, receiver.stats().sentences);
+  TEST_ASSERT_EQUAL_UINT32(0, receiver.stats().checksumErrors);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_checksum);
+  RUN_TEST(test_unchecked);
+  RUN_TEST(test_fields);
+  RUN_TEST(test_resync);
+  RUN_TEST(test_too_long);
+  RUN_TEST(test_field_copy);
+  RUN_TEST(test_field_tenths);
+  RUN_TEST(test_log);
+  return UNITY_END();
+}
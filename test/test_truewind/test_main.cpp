@@ -0,0 +1,171 @@
+/*
+  Project:  YAZZ_WindDisplay_ESP32, Copyright 2020, Roy Wassili
+  File:     test_truewind/test_main.cpp
+  Purpose:  Unit tests of the fixed-point true wind kernel against the
+            calculation in double and float, run with: pio test -e native
+*/
+#include <Arduino.h>
+#include <unity.h>
+#include <math.h>
+#include "TrueWind.h"
+#include "TrueWindRef.h"
+
+/*** Difference of two angles in degrees, 0..180
+*/
+static double angleError(double a, double b)
+{
+  return fabs(fmod(a - b + 540, 360) - 180);
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_sin_cos(void)
+{
+  TEST_ASSERT_EQUAL_INT(0, twSin(0));
+  TEST_ASSERT_EQUAL_INT(32767, twSin(900));
+  TEST_ASSERT_EQUAL_INT(-32767, twSin(-900));
+  TEST_ASSERT_EQUAL_INT(twSin(300), twSin(300 + 3600));
+  TEST_ASSERT_EQUAL_INT(twCos(0), twSin(900));
+  for (int32_t a = -3600; a <= 3600; a += 3)
+  {
+    TEST_ASSERT_DOUBLE_WITHIN(2e-4, sin(a / 10.0 * PI / 180), twSin(a) / 32767.0);
+  }
+}
+
+void test_atan2(void)
+{
+  TEST_ASSERT_EQUAL_INT(0, twAtan2(0, 0));
+  TEST_ASSERT_EQUAL_INT(0, twAtan2(0, 100));
+  TEST_ASSERT_EQUAL_INT(900, twAtan2(100, 0));
+  TEST_ASSERT_EQUAL_INT(-900, twAtan2(-100, 0));
+  TEST_ASSERT_EQUAL_INT(1800, twAtan2(0, -100));
+  for (int32_t a = -1799; a < 1800; a += 7)
+  {
+    int32_t x = lround(cos(a / 10.0 * PI / 180) * 100000);
+    int32_t y = lround(sin(a / 10.0 * PI / 180) * 100000);
+    TEST_ASSERT_DOUBLE_WITHIN(1.0, a, twAtan2(y, x));
+  }
+}
+
+void test_sqrt(void)
+{
+  TEST_ASSERT_EQUAL_UINT(0, twSqrt(0));
+  TEST_ASSERT_EQUAL_UINT(1, twSqrt(3));
+  TEST_ASSERT_EQUAL_UINT(2, twSqrt(4));
+  TEST_ASSERT_EQUAL_UINT(65535, twSqrt(0xFFFFFFFF));
+  for (uint64_t v = 1; v <= 0xFFFFFFFF; v += v / 7 + 1)
+  {
+    uint32_t r = twSqrt(v);
+    TEST_ASSERT_TRUE((uint64_t)r * r <= v && (uint64_t)(r + 1) * (r + 1) > v);
+  }
+}
+
+/*** The kernel against double for AWS 0..60kn, SOG 0..25kn and every AWA in
+ * steps of 0.7 degrees; TWS within rounding, the angles within half a
+ * degree and the VMG within 0.15kn, which is the resolution of the vector
+ * of a 1kn true wind
+ */
+void test_against_double(void)
+{
+  double maxTws = 0, maxTwa = 0, maxTwd = 0, maxVmg = 0;
+  for (int32_t aws = 0; aws <= 600; aws += 7)
+  {
+    for (int32_t sog = 0; sog <= 250; sog += 5)
+    {
+      for (int32_t awa = -1800; awa <= 1800; awa += 7)
+      {
+        int32_t cog = (aws * 13 + sog * 7 + awa) % 3600;
+        TrueWind tw;
+        double ref[4];
+        twCalculate(aws, awa, sog, cog, &tw);
+        trueWindDouble(aws, awa, sog, cog, ref);
+        maxTws = fmax(maxTws, fabs(tw.tws / 10.0 - ref[0]));
+        // the direction of less than a knot of wind is meaningless
+        if (ref[0] >= 1.0)
+        {
+          maxTwa = fmax(maxTwa, angleError(tw.twa / 10.0, ref[1]));
+          maxTwd = fmax(maxTwd, angleError(tw.twd / 10.0, ref[2]));
+          maxVmg = fmax(maxVmg, fabs(tw.vmg / 10.0 - ref[3]));
+        }
+      }
+    }
+  }
+  TEST_ASSERT_LESS_OR_EQUAL(0.1, maxTws);
+  TEST_ASSERT_LESS_OR_EQUAL(0.5, maxTwa);
+  TEST_ASSERT_LESS_OR_EQUAL(0.5, maxTwd);
+  TEST_ASSERT_LESS_OR_EQUAL(0.15, maxVmg);
+}
+
+/*** The kernel gives the values shown before by the float calculation,
+ * within the tenth they are shown in
+ */
+void test_against_float(void)
+{
+  uint32_t seed = 1;
+  for (int i = 0; i < 10000; i++)
+  {
+    int32_t in[4];
+    for (int j = 0; j < 4; j++)
+    {
+      seed = seed * 1103515245 + 12345;
+      in[j] = (seed >> 16) % (j == 1 ? 3600 : 600) - (j == 1 ? 1800 : 0);
+    }
+    TrueWind tw;
+    float ref[4];
+    twCalculate(in[0], in[1], in[2], in[3], &tw);
+    trueWindFloat(in[0], in[1], in[2], in[3], ref);
+    TEST_ASSERT_DOUBLE_WITHIN(0.1, ref[0], tw.tws / 10.0);
+    if (ref[0] >= 1.0f)
+    {
+      TEST_ASSERT_LESS_OR_EQUAL(0.5, angleError(tw.twa / 10.0, ref[1]));
+      TEST_ASSERT_LESS_OR_EQUAL(0.5, angleError(tw.twd / 10.0, ref[2]));
+    }
+  }
+}
+
+void test_clipped_input(void)
+{
+  TrueWind tw;
+  twCalculate(TW_MAX_SPEED * 2, 1800, TW_MAX_SPEED * 2, 0, &tw);
+  TEST_ASSERT_EQUAL_INT32(TW_MAX_SPEED * 2, tw.tws);
+  twCalculate(-10, 0, -10, 0, &tw);
+  TEST_ASSERT_EQUAL_INT32(0, tw.tws);
+  TEST_ASSERT_EQUAL_INT(0, tw.twa);
+}
+
+void test_history(void)
+{
+  WindHistory history;
+  TEST_ASSERT_EQUAL_UINT8(0, history.count());
+  // around north the mean doesn't jump to the south
+  history.add(100, 3500);
+  history.add(150, 100);
+  TEST_ASSERT_DOUBLE_WITHIN(1, 0, angleError(history.meanDirection() / 10.0, 0));
+  TEST_ASSERT_EQUAL_INT32(150, history.maxSpeed());
+  for (int i = 0; i < TW_HISTORY; i++)
+  {
+    history.add(80, 900);
+  }
+  TEST_ASSERT_EQUAL_UINT8(TW_HISTORY, history.count());
+  TEST_ASSERT_DOUBLE_WITHIN(1, 900, history.meanDirection());
+  TEST_ASSERT_EQUAL_INT32(80, history.maxSpeed());
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_sin_cos);
+  RUN_TEST(test_atan2);
+  RUN_TEST(test_sqrt);
+  RUN_TEST(test_against_double);
+  RUN_TEST(test_against_float);
+  RUN_TEST(test_clipped_input);
+  RUN_TEST(test_history);
+  return UNITY_END();
+}